@@ -36,8 +36,8 @@ void linear_to_sRGB(cv::Mat& img) {
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> <scale_factor>\n";
+    if (argc != 4 && argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> <scale_factor> [float|double]\n";
         return -1;
     }
 
@@ -59,6 +59,18 @@ int main(int argc, char* argv[]) {
         return -1;
     }
 
+    Precision precision = Precision::Double;
+    if (argc == 5) {
+        std::string name = argv[4];
+        if (name == "float") {
+            precision = Precision::Float;
+        }
+        else if (name != "double") {
+            std::cerr << "Error: Precision must be float or double.\n";
+            return -1;
+        }
+    }
+
     // Check if the input image exists
     if (!fs::exists(input_image_path)) {
         std::cerr << "Error: Input image does not exist: " << input_image_path << "\n";
@@ -97,7 +109,8 @@ int main(int argc, char* argv[]) {
             out_width,
             out_height,
             channels,
-            a);
+            a,
+            precision);
     }
     catch (const std::exception& e) {
         std::cerr << "Error during resampling: " << e.what() << "\n";
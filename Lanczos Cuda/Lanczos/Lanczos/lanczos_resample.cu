@@ -6,16 +6,20 @@
 
 using namespace std;
 
-__device__ double lanczos_kernel(double x, int a) {
-    if (x == 0.0) return 1.0;
-    if (x <= -a || x >= a) return 0.0;
-    double pix = PI * x;
+// T is the weight/accumulator type: float runs at full rate on consumer GPUs,
+// double is kept as the reference.
+template <typename T>
+__device__ T lanczos_kernel(T x, int a) {
+    if (x == T(0)) return T(1);
+    if (x <= -a || x >= a) return T(0);
+    T pix = T(PI) * x;
     return (sin(pix) * sin(pix / a)) / (pix * pix / a);
 }
 
 
 
 // CUDA kernel for Lanczos resampling
+template <typename T>
 __global__ void lanczos_resample_kernel(
     const unsigned char* input,
     unsigned char* output,
@@ -34,14 +38,17 @@ __global__ void lanczos_resample_kernel(
 
     int idx_out = (y * out_width + x) * channels;
 
-    double sum[3] = { 0.0, 0.0, 0.0 };
-    double sum_weight = 0.0;
+    // Up to 4 channels. A 4th channel is treated as straight alpha and colours are
+    // accumulated premultiplied by it, which avoids dark fringes at transparent edges.
+    T sum[4] = { T(0), T(0), T(0), T(0) };
+    T sum_weight = T(0);
+    bool premultiply = (channels == 4);
 
     // Compute the corresponding input coordinate
-    double scale_x = static_cast<double>(out_width) / in_width;
-    double scale_y = static_cast<double>(out_height) / in_height;
-    double src_x = (x + 0.5) / scale_x - 0.5;
-    double src_y = (y + 0.5) / scale_y - 0.5;
+    T scale_x = static_cast<T>(out_width) / in_width;
+    T scale_y = static_cast<T>(out_height) / in_height;
+    T src_x = (x + T(0.5)) / scale_x - T(0.5);
+    T src_y = (y + T(0.5)) / scale_y - T(0.5);
 
     // Compute the window boundaries
     int x_start = static_cast<int>(floor(src_x - a + 1));
@@ -55,27 +62,44 @@ __global__ void lanczos_resample_kernel(
     y_end = min(in_height - 1, y_end);
 
     for (int j = y_start; j <= y_end; ++j) {
-        double dist_y = src_y - j;
-        double wy = lanczos_kernel(dist_y, a);
+        T dist_y = src_y - j;
+        T wy = lanczos_kernel(dist_y, a);
         for (int i = x_start; i <= x_end; ++i) {
-            double dist_x = src_x - i;
-            double wx = lanczos_kernel(dist_x, a);
-            double weight = wx * wy;
+            T dist_x = src_x - i;
+            T wx = lanczos_kernel(dist_x, a);
+            T weight = wx * wy;
 
             int idx_in = (j * in_width + i) * channels;
 
-            for (int c = 0; c < channels; ++c) {
-                sum[c] += weight * input[idx_in + c];
+            if (premultiply) {
+                T weighted_alpha = weight * input[idx_in + 3];
+                for (int c = 0; c < 3; ++c) {
+                    sum[c] += weighted_alpha * input[idx_in + c];
+                }
+                sum[3] += weighted_alpha;
+            }
+            else {
+                for (int c = 0; c < channels; ++c) {
+                    sum[c] += weight * input[idx_in + c];
+                }
             }
             sum_weight += weight;
         }
     }
 
-    if (sum_weight > 0.0) {
+    if (premultiply && sum[3] > T(0)) {
+        for (int c = 0; c < 3; ++c) {
+            sum[c] = fmin(fmax(sum[c] / sum[3], T(0)), T(255));
+            output[idx_out + c] = static_cast<unsigned char>(sum[c] + T(0.5));
+        }
+        sum[3] = fmin(fmax(sum[3] / sum_weight, T(0)), T(255));
+        output[idx_out + 3] = static_cast<unsigned char>(sum[3] + T(0.5));
+    }
+    else if (!premultiply && sum_weight > T(0)) {
         for (int c = 0; c < channels; ++c) {
             sum[c] /= sum_weight;
-            sum[c] = fmin(fmax(sum[c], 0.0), 255.0);
-            output[idx_out + c] = static_cast<unsigned char>(sum[c] + 0.5);
+            sum[c] = fmin(fmax(sum[c], T(0)), T(255));
+            output[idx_out + c] = static_cast<unsigned char>(sum[c] + T(0.5));
         }
     }
     else {
@@ -124,12 +148,18 @@ void lanczos_resample_cuda(
     int out_width,
     int out_height,
     int channels,
-    int a)
+    int a,
+    Precision precision)
 {
     // Allocate device memory for input and output images
     unsigned char* d_input = nullptr;
     unsigned char* d_output = nullptr;
 
+    if (channels < 1 || channels > 4) {
+        std::cerr << "Unsupported channel count for CUDA resampling: " << channels << std::endl;
+        return;
+    }
+
     size_t input_size = in_width * in_height * channels * sizeof(unsigned char);
     size_t output_size = out_width * out_height * channels * sizeof(unsigned char);
 
@@ -162,15 +192,28 @@ void lanczos_resample_cuda(
     dim3 gridSize((out_width + blockSize.x - 1) / blockSize.x,
                   (out_height + blockSize.y - 1) / blockSize.y);
 
-    lanczos_resample_kernel<<<gridSize, blockSize>>>(
-        d_input,
-        d_output,
-        in_width,
-        in_height,
-        out_width,
-        out_height,
-        channels,
-        a);
+    if (precision == Precision::Float) {
+        lanczos_resample_kernel<float><<<gridSize, blockSize>>>(
+            d_input,
+            d_output,
+            in_width,
+            in_height,
+            out_width,
+            out_height,
+            channels,
+            a);
+    }
+    else {
+        lanczos_resample_kernel<double><<<gridSize, blockSize>>>(
+            d_input,
+            d_output,
+            in_width,
+            in_height,
+            out_width,
+            out_height,
+            channels,
+            a);
+    }
 
     // Check for kernel errors
     err = cudaGetLastError();
@@ -80,6 +80,10 @@
 //    }
 //};
 
+// Weight/accumulator type for the resampling kernel. Float is visually identical
+// for 8-bit images and much faster on consumer GPUs; Double is the reference.
+enum class Precision { Float, Double };
+
 // Lanczos weight function
 template<int TTap>
 struct LanczosWeight {
@@ -100,6 +104,7 @@ void lanczos_resample_cuda(
     int out_width,
     int out_height,
     int channels,
-    int a);
+    int a,
+    Precision precision = Precision::Double);
 
 #endif  // LANCZOS_RESAMPLE_H
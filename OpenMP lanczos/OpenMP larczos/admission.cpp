@@ -0,0 +1,151 @@
+#include "admission.h"
+#include "tuning.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+namespace {
+    size_t pixels(int width, int height) {
+        return static_cast<size_t>(width) * static_cast<size_t>(height);
+    }
+
+    // Tap tables of one separable axis: first index, then index and weight per tap.
+    // Downscaling widens the kernel by the reduction ratio.
+    size_t axis_bytes(int input_size, int output_size, const Pipeline::Params& params) {
+        const int support = params.filter == "bicubic" ? 4 : 2 * params.taps;
+        const double ratio = std::max(1.0, static_cast<double>(input_size) / output_size);
+        const size_t taps = static_cast<size_t>(support * ratio) + 1;
+        const size_t weight = params.precision == Precision::Float ? sizeof(float) : sizeof(double);
+        return static_cast<size_t>(output_size) * (sizeof(int) + taps * (sizeof(int) + weight));
+    }
+
+    bool uses_rgbx(const Pipeline::Params& params, int channels, int output_width, int output_height) {
+        if (channels != 3) return false;
+        if (params.rgbx) return true;
+        Tuning::Config config;
+        return params.use_profile && params.precision == Precision::Double
+            && Tuning::lookup(static_cast<long long>(output_width) * output_height, config) && config.rgbx;
+    }
+}
+
+namespace Admission {
+    size_t estimate(const Job& job, const Pipeline::Params& params, Mode mode) {
+        const size_t input = pixels(job.input_width, job.input_height) * job.channels;
+        size_t total = job.compressed_bytes + input;
+
+        for (const auto& [width, height] : job.outputs) {
+            const size_t output = pixels(width, height) * job.channels;
+            total += axis_bytes(job.input_width, width, params) + axis_bytes(job.input_height, height, params);
+
+            if (mode == Mode::Streamed) {
+                // One band of tile rows plus the encoder's MCU-row buffers.
+                const size_t row = static_cast<size_t>(width) * job.channels;
+                total += row * (Tiles::current_size().height + 32);
+                continue;
+            }
+
+            // Output vector, then the encoded strips and their stitched copy (generously
+            // half the raw size together at the default quality).
+            total += output + output / 2;
+            if (uses_rgbx(params, job.channels, width, height)) {
+                total += pixels(job.input_width, job.input_height) * 4 + pixels(width, height) * 4;
+            }
+        }
+        return total;
+    }
+
+    Budget::Ticket::Ticket(Budget* budget, Mode mode, size_t bytes, double waited_ms)
+        : budget(budget), chosen(mode), reserved(bytes), waited(waited_ms) {}
+
+    Budget::Ticket::Ticket(Ticket&& other) noexcept
+        : budget(other.budget), chosen(other.chosen), reserved(other.reserved), waited(other.waited) {
+        other.budget = nullptr;
+    }
+
+    Budget::Ticket::~Ticket() {
+        if (budget) budget->release(reserved);
+    }
+
+    Budget::Budget(size_t bytes, int concurrency)
+        : limit(std::max<size_t>(bytes, 1)), concurrency(std::max(concurrency, 1)) {}
+
+    Mode Budget::route(const Job& job, const Pipeline::Params& params) const {
+        // Only plain single-target Lanczos and bicubic have a tiled path; adaptive kernel
+        // selection would be lost, so those jobs stay in memory and just wait longer.
+        const bool streamable = job.outputs.size() == 1 && params.adaptive_threshold <= 0
+            && (params.filter == "lanczos" || params.filter == "bicubic");
+        if (streamable && estimate(job, params, Mode::InMemory) > limit / concurrency) return Mode::Streamed;
+        return Mode::InMemory;
+    }
+
+    Budget::Ticket Budget::admit(const Job& job, Pipeline::Params& params) {
+        const Mode mode = route(job, params);
+        if (mode == Mode::Streamed) params.rgbx = false;
+        const size_t bytes = estimate(job, params, mode);
+
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        const unsigned long long ticket = next_ticket++;
+        ++waiting;
+        changed.wait(lock, [&] {
+            return ticket == serving && (in_use + bytes <= limit || in_use == 0);
+        });
+        --waiting;
+        ++serving;
+
+        in_use += bytes;
+        peak = std::max(peak, in_use);
+        ++admitted;
+        if (mode == Mode::Streamed) ++streamed;
+        if (bytes > limit) ++oversized;
+
+        const double waited_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (waits.size() < window) waits.push_back(waited_ms);
+        else waits[next_wait % window] = waited_ms;
+        ++next_wait;
+        max_wait = std::max(max_wait, waited_ms);
+
+        lock.unlock();
+        // The next ticket in line may fit alongside this one.
+        changed.notify_all();
+        return Ticket(this, mode, bytes, waited_ms);
+    }
+
+    void Budget::release(size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            in_use -= bytes;
+        }
+        changed.notify_all();
+    }
+
+    std::string Budget::report() const {
+        std::vector<double> sorted;
+        double longest;
+        std::ostringstream out;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sorted = waits;
+            longest = max_wait;
+            out << "memory_budget=" << limit << "\n"
+                << "memory_in_use=" << in_use << "\n"
+                << "memory_peak=" << peak << "\n"
+                << "admitted=" << admitted << "\n"
+                << "admitted_streamed=" << streamed << "\n"
+                << "admitted_oversized=" << oversized << "\n"
+                << "admission_waiting=" << waiting << "\n";
+        }
+        std::sort(sorted.begin(), sorted.end());
+        for (double p : { 50.0, 99.0 }) {
+            double value = 0.0;
+            if (!sorted.empty()) {
+                size_t rank = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+                value = sorted[rank];
+            }
+            out << "admission_wait_p" << static_cast<int>(p) << "_ms=" << value << "\n";
+        }
+        out << "admission_wait_max_ms=" << longest << "\n";
+        return out.str();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "pipeline.h"
+
+// Memory-budgeted admission for concurrently running resize jobs.
+//
+// Each job's peak footprint is estimated from its sizes, channels and algorithm before
+// anything is decoded, and jobs start only while the estimates of all admitted jobs fit
+// the budget. Admission is first come, first served, so a large job is not starved by a
+// stream of small ones; a job larger than the whole budget runs alone.
+namespace Admission {
+    enum class Mode {
+        InMemory,   // decode, resample into a vector, parallel encode
+        Streamed    // Pipeline::resample_streamed: output kept in a file-backed tiled container
+    };
+
+    struct Job {
+        int input_width = 0, input_height = 0, channels = 0;
+        std::vector<std::pair<int, int>> outputs;   // one entry per target size
+        size_t compressed_bytes = 0;                // encoded input held for the whole job
+    };
+
+    // Peak bytes of one job. Lanczos and bicubic read the 8-bit input directly, so the
+    // big buffers are the input, the output and the encoded strips; RGBX adds padded
+    // copies of both.
+    size_t estimate(const Job& job, const Pipeline::Params& params, Mode mode);
+
+    class Budget {
+    public:
+        // `concurrency` is how many jobs normally run at once; a single-output job whose
+        // in-memory estimate is above budget / concurrency is routed to the streamed mode.
+        Budget(size_t bytes, int concurrency);
+
+        // Holds a job's share of the budget until destroyed.
+        class Ticket {
+        public:
+            Ticket(Ticket&& other) noexcept;
+            Ticket(const Ticket&) = delete;
+            Ticket& operator=(const Ticket&) = delete;
+            Ticket& operator=(Ticket&&) = delete;
+            ~Ticket();
+
+            Mode mode() const { return chosen; }
+            size_t bytes() const { return reserved; }
+            double waited_ms() const { return waited; }
+
+        private:
+            friend class Budget;
+            Ticket(Budget* budget, Mode mode, size_t bytes, double waited_ms);
+
+            Budget* budget;
+            Mode chosen;
+            size_t reserved;
+            double waited;
+        };
+
+        Mode route(const Job& job, const Pipeline::Params& params) const;
+
+        // Routes the job and blocks until its estimate fits. In streamed mode the RGBX
+        // layout is turned off in `params`, as it does not apply to tiled output.
+        Ticket admit(const Job& job, Pipeline::Params& params);
+
+        size_t capacity() const { return limit; }
+
+        // "key=value" lines for the daemon's stats reply.
+        std::string report() const;
+
+    private:
+        void release(size_t bytes);
+
+        size_t limit;
+        int concurrency;
+
+        mutable std::mutex mutex;
+        std::condition_variable changed;
+        size_t in_use = 0;
+        size_t peak = 0;
+        unsigned long long next_ticket = 0;
+        unsigned long long serving = 0;
+        size_t waiting = 0;
+        size_t admitted = 0;
+        size_t streamed = 0;
+        size_t oversized = 0;
+
+        static constexpr size_t window = 1024;
+        std::vector<double> waits;     // most recent admission waits (ring)
+        size_t next_wait = 0;
+        double max_wait = 0.0;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "affine.h"
+#include "kernel_lut.h"
+#include "lanczos.h"
+#include "tiles.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#define M_PI 3.14159265358979323846
+
+namespace {
+    template <typename T>
+    std::vector<unsigned char> warp_impl(const std::vector<unsigned char>& input,
+                                         int input_width, int input_height, int channels,
+                                         int output_width, int output_height,
+                                         const Affine::Transform& inverse,
+                                         int a, int lut_resolution, EdgeMode edge, bool premultiply) {
+        const double* m = inverse.m;
+
+        // When the warp minifies, stretch the kernel so it still low-pass filters.
+        // Row i of the inverse matrix is the gradient of source coordinate i over destination
+        // pixels, so its length is the largest source step along that axis per destination
+        // pixel. (A column would mix the axes: rotated 90 degrees, column 0 holds the y step.)
+        T filter_x = static_cast<T>(std::max(1.0, std::hypot(m[0], m[1])));
+        T filter_y = static_cast<T>(std::max(1.0, std::hypot(m[3], m[4])));
+        int radius_x = static_cast<int>(std::ceil(a * filter_x));
+        int radius_y = static_cast<int>(std::ceil(a * filter_y));
+
+        KernelLUT<T> lut([a](double x) { return Lanczos::kernel(x, a); }, static_cast<T>(a), lut_resolution);
+
+        std::vector<unsigned char> output(static_cast<size_t>(output_width) * output_height * channels, 0);
+        const size_t row_stride = static_cast<size_t>(input_width) * channels;
+
+        Tiles::parallel_for(output_width, output_height, Tiles::current_size(), [&](const Tiles::Tile& tile) {
+            std::vector<T> wx(2 * radius_x + 1);
+            std::vector<T> wy(2 * radius_y + 1);
+
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                for (int x = tile.x0; x < tile.x1; ++x) {
+                    T src_x = static_cast<T>(m[0] * x + m[1] * y + m[2]);
+                    T src_y = static_cast<T>(m[3] * x + m[4] * y + m[5]);
+                    if (src_x < T(-0.5) || src_y < T(-0.5) || src_x > input_width - T(0.5) || src_y > input_height - T(0.5)) {
+                        continue;
+                    }
+
+                    int x_i = static_cast<int>(std::floor(src_x));
+                    int y_i = static_cast<int>(std::floor(src_y));
+                    int x_first = x_i - radius_x + 1;
+                    int y_first = y_i - radius_y + 1;
+                    int x_taps = 2 * radius_x;
+                    int y_taps = 2 * radius_y;
+                    for (int k = 0; k < x_taps; ++k) wx[k] = lut((src_x - (x_first + k)) / filter_x);
+                    for (int k = 0; k < y_taps; ++k) wy[k] = lut((src_y - (y_first + k)) / filter_y);
+
+                    bool interior = x_first >= 0 && y_first >= 0 &&
+                                    x_first + x_taps <= input_width && y_first + y_taps <= input_height;
+
+                    T sum[4] = {};
+                    T normalizer = 0;
+                    for (int n = 0; n < y_taps; ++n) {
+                        if (wy[n] == T(0)) continue;
+                        int sy = interior ? y_first + n : resolve_edge(y_first + n, input_height, edge);
+                        const unsigned char* row = input.data() + sy * row_stride;
+                        for (int k = 0; k < x_taps; ++k) {
+                            T weight = wx[k] * wy[n];
+                            int sx = interior ? x_first + k : resolve_edge(x_first + k, input_width, edge);
+                            const unsigned char* p = row + static_cast<size_t>(sx) * channels;
+                            if (premultiply) {
+                                T weighted_alpha = weight * p[3];
+                                for (int c = 0; c < 3; ++c) sum[c] += weighted_alpha * p[c];
+                                sum[3] += weighted_alpha;
+                            }
+                            else {
+                                for (int c = 0; c < channels; ++c) sum[c] += weight * p[c];
+                            }
+                            normalizer += weight;
+                        }
+                    }
+
+                    unsigned char* out = &output[(static_cast<size_t>(y) * output_width + x) * channels];
+                    if (premultiply) {
+                        for (int c = 0; c < 3; ++c) {
+                            T color = (sum[3] > T(0)) ? sum[c] / sum[3] : T(0);
+                            out[c] = static_cast<unsigned char>(std::clamp(color, T(0), T(255)));
+                        }
+                        out[3] = static_cast<unsigned char>(std::clamp(sum[3] / normalizer, T(0), T(255)));
+                    }
+                    else {
+                        for (int c = 0; c < channels; ++c) {
+                            out[c] = static_cast<unsigned char>(std::clamp(sum[c] / normalizer, T(0), T(255)));
+                        }
+                    }
+                }
+            }
+        });
+
+        return output;
+    }
+}
+
+namespace Affine {
+    Transform invert(const Transform& transform) {
+        const double* m = transform.m;
+        double det = m[0] * m[4] - m[1] * m[3];
+        if (std::abs(det) < 1e-12) {
+            throw std::invalid_argument("Affine transform is not invertible");
+        }
+
+        Transform inverse;
+        double* r = inverse.m;
+        r[0] = m[4] / det;
+        r[1] = -m[1] / det;
+        r[3] = -m[3] / det;
+        r[4] = m[0] / det;
+        r[2] = -(r[0] * m[2] + r[1] * m[5]);
+        r[5] = -(r[3] * m[2] + r[4] * m[5]);
+        return inverse;
+    }
+
+    Transform rotation(double degrees, int input_width, int input_height, bool expand,
+                       int& output_width, int& output_height) {
+        double radians = degrees * M_PI / 180.0;
+        double c = std::cos(radians);
+        double s = std::sin(radians);
+
+        output_width = input_width;
+        output_height = input_height;
+        if (expand) {
+            output_width = static_cast<int>(std::ceil(std::abs(input_width * c) + std::abs(input_height * s) - 1e-9));
+            output_height = static_cast<int>(std::ceil(std::abs(input_width * s) + std::abs(input_height * c) - 1e-9));
+        }
+
+        // Rotate about the source centre, then move it onto the destination centre.
+        double in_cx = (input_width - 1) / 2.0;
+        double in_cy = (input_height - 1) / 2.0;
+        double out_cx = (output_width - 1) / 2.0;
+        double out_cy = (output_height - 1) / 2.0;
+
+        Transform transform;
+        transform.m[0] = c;
+        transform.m[1] = -s;
+        transform.m[2] = out_cx - (c * in_cx - s * in_cy);
+        transform.m[3] = s;
+        transform.m[4] = c;
+        transform.m[5] = out_cy - (s * in_cx + c * in_cy);
+        return transform;
+    }
+
+    std::vector<unsigned char> warp(const std::vector<unsigned char>& input,
+                                    int input_width, int input_height, int channels,
+                                    int output_width, int output_height,
+                                    const Transform& transform,
+                                    int a, int lut_resolution,
+                                    Precision precision, EdgeMode edge, AlphaMode alpha) {
+        if (channels < 1 || channels > 4) {
+            throw std::invalid_argument("Unsupported channel count: " + std::to_string(channels));
+        }
+
+        Transform inverse = invert(transform);
+        bool premultiply = (channels == 4 && alpha == AlphaMode::Premultiply);
+        if (precision == Precision::Float) {
+            return warp_impl<float>(input, input_width, input_height, channels, output_width, output_height,
+                                    inverse, a, lut_resolution, edge, premultiply);
+        }
+        return warp_impl<double>(input, input_width, input_height, channels, output_width, output_height,
+                                 inverse, a, lut_resolution, edge, premultiply);
+    }
+}
\ No newline at end of file
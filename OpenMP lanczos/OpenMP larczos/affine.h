@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include "precision.h"
+#include "edge_mode.h"
+#include "pixel_format.h"
+
+// General affine resampling (rotation, deskew, shear, non-uniform scale) with a Lanczos
+// kernel. The warp is not separable, so weights are evaluated per output pixel from an
+// interpolated lookup table instead of sin().
+namespace Affine {
+    // Forward mapping from source to destination pixel-centre coordinates:
+    //   x' = m[0] * x + m[1] * y + m[2]
+    //   y' = m[3] * x + m[4] * y + m[5]
+    struct Transform {
+        double m[6] = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
+    };
+
+    Transform invert(const Transform& transform);
+
+    // Rotation about the image centre. With expand the output grows to hold the whole
+    // rotated image; otherwise it keeps the input size (deskew).
+    Transform rotation(double degrees, int input_width, int input_height, bool expand,
+                       int& output_width, int& output_height);
+
+    // Destination pixels whose centre maps outside the source are filled with zeros
+    // (transparent for 4-channel images). lut_resolution is kernel samples per unit.
+    std::vector<unsigned char> warp(const std::vector<unsigned char>& input,
+                                    int input_width, int input_height, int channels,
+                                    int output_width, int output_height,
+                                    const Transform& transform,
+                                    int a = 3, int lut_resolution = 1024,
+                                    Precision precision = Precision::Double,
+                                    EdgeMode edge = EdgeMode::Clamp,
+                                    AlphaMode alpha = AlphaMode::Premultiply);
+}
\ No newline at end of file
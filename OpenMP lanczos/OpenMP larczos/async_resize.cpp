@@ -0,0 +1,163 @@
+#include "async_resize.h"
+#include "tiles.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+namespace AsyncResize {
+    CancellationToken::CancellationToken() : shared(std::make_shared<Shared>()) {}
+
+    void CancellationToken::cancel() {
+        std::map<size_t, std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->flag.store(true);
+            callbacks.swap(shared->callbacks);
+        }
+        for (auto& [id, fn] : callbacks) fn();
+    }
+
+    bool CancellationToken::on_cancel(size_t& id, std::function<void()> fn) {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (shared->flag.load()) return false;
+        id = shared->next_id++;
+        shared->callbacks.emplace(id, std::move(fn));
+        return true;
+    }
+
+    void CancellationToken::remove(size_t id) {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->callbacks.erase(id);
+    }
+
+    struct ResizeAwaitable::State {
+        // Whoever moves phase out of Queued (a worker or the cancel callback) owns the
+        // resumption; the other side backs off.
+        enum Phase { Queued, Running, Finished };
+
+        ImageView view;
+        Pipeline::Params params;
+        CancellationToken cancel;
+        Resumer resume_on;
+        std::coroutine_handle<> caller;
+        Image result;
+        std::exception_ptr error;
+        std::atomic<int> phase{ Queued };
+        size_t cancel_id = 0;
+    };
+
+    namespace {
+        std::mutex pool_mutex;
+        int pool_workers = std::max(2, static_cast<int>(std::thread::hardware_concurrency() / 4));
+        size_t pool_capacity = 256;
+        std::unique_ptr<WorkerPool> shared_pool;
+
+        WorkerPool& pool() {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            if (!shared_pool) shared_pool = std::make_unique<WorkerPool>(pool_workers, pool_capacity);
+            return *shared_pool;
+        }
+
+        class ScopedCancel {
+        public:
+            explicit ScopedCancel(const std::atomic<bool>* flag) : saved(Tiles::current_cancel()) { Tiles::current_cancel() = flag; }
+            ~ScopedCancel() { Tiles::current_cancel() = saved; }
+
+        private:
+            const std::atomic<bool>* saved;
+        };
+
+        void resume(ResizeAwaitable::State& state) {
+            if (state.resume_on) state.resume_on(state.caller);
+            else state.caller.resume();
+        }
+
+        void run(ResizeAwaitable::State& state) {
+            if (state.cancel.cancelled()) throw Cancelled();
+
+            const ImageView& view = state.view;
+            const size_t stride = view.stride ? view.stride : static_cast<size_t>(view.width) * view.channels;
+
+            Image& out = state.result;
+            Pipeline::resolve_size(state.params, view.width, view.height, out.width, out.height);
+            out.channels = view.channels;
+
+            {
+                ScopedCancel scoped(state.cancel.get());
+                out.pixels = Pipeline::resample(view.data, stride, view.width, view.height, view.channels, out.width, out.height, state.params);
+            }
+
+            // Tiles skipped after a cancel leave the buffer incomplete; never hand it out.
+            if (state.cancel.cancelled()) throw Cancelled();
+        }
+    }
+
+    bool ResizeAwaitable::await_suspend(std::coroutine_handle<> caller) {
+        using Phase = State::Phase;
+        state->caller = caller;
+        std::shared_ptr<State> job = state;
+
+        // Registered before submitting, so a cancel can never miss a queued job. The
+        // callback holds the job until it runs or the worker removes it.
+        bool registered = job->cancel.on_cancel(job->cancel_id, [job] {
+            int expected = Phase::Queued;
+            if (job->phase.compare_exchange_strong(expected, Phase::Finished)) {
+                job->error = std::make_exception_ptr(Cancelled());
+                resume(*job);
+            }
+        });
+        if (!registered) {
+            state->error = std::make_exception_ptr(Cancelled());
+            return false;
+        }
+
+        bool queued = pool().try_submit([job] {
+            int expected = Phase::Queued;
+            if (!job->phase.compare_exchange_strong(expected, Phase::Running)) return; // cancelled while queued
+            job->cancel.remove(job->cancel_id);
+            try {
+                run(*job);
+            }
+            catch (...) {
+                job->error = std::current_exception();
+            }
+            job->phase.store(Phase::Finished);
+            resume(*job);
+        });
+        if (queued) return true;
+
+        // From here on only `job` is touched: a concurrent cancel() may already have resumed
+        // the caller and destroyed this awaitable.
+        int expected = Phase::Queued;
+        if (!job->phase.compare_exchange_strong(expected, Phase::Finished)) return true;
+        job->cancel.remove(job->cancel_id);
+        job->error = std::make_exception_ptr(std::runtime_error("Resize queue full"));
+        return false;
+    }
+
+    Image ResizeAwaitable::await_resume() {
+        if (state->error) std::rethrow_exception(state->error);
+        return std::move(state->result);
+    }
+
+    ResizeAwaitable resize_async(ImageView view, Pipeline::Params params, CancellationToken cancel, Resumer resume_on) {
+        if (!view.data || view.width <= 0 || view.height <= 0 || view.channels <= 0) {
+            throw std::invalid_argument("Empty image view");
+        }
+        auto state = std::make_shared<ResizeAwaitable::State>();
+        state->view = view;
+        state->params = std::move(params);
+        state->cancel = std::move(cancel);
+        state->resume_on = std::move(resume_on);
+        return ResizeAwaitable(std::move(state));
+    }
+
+    bool configure_pool(int workers, size_t queue_capacity) {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (shared_pool) return false;
+        pool_workers = std::max(workers, 1);
+        pool_capacity = std::max<size_t>(queue_capacity, 1);
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "pipeline.h"
+
+// Awaitable resize for event-driven callers (C++20 coroutines):
+//
+//     AsyncResize::Image out = co_await AsyncResize::resize_async(view, params, token);
+//
+// The resample runs on a shared internal WorkerPool, so the awaiting thread is free
+// while it runs. On completion the coroutine is resumed on the worker thread, or handed
+// to `resume_on` (e.g. the server's event-loop post function) when one is given.
+namespace AsyncResize {
+    // Borrowed pixels, read in place; must stay valid until the co_await completes.
+    struct ImageView {
+        const unsigned char* data = nullptr;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        size_t stride = 0;        // bytes between rows; 0 = width * channels
+    };
+
+    struct Image {
+        std::vector<unsigned char> pixels;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+    };
+
+    // Thrown from co_await when the job was cancelled before it finished.
+    class Cancelled : public std::runtime_error {
+    public:
+        Cancelled() : std::runtime_error("Resize cancelled") {}
+    };
+
+    // Copyable handle; cancel() on any copy cancels every resize it was passed to. A job
+    // still queued is resumed with Cancelled from within cancel() (through `resume_on` when
+    // given, otherwise on the cancelling thread) and its queue slot becomes a no-op; a
+    // running one stops scheduling new tiles and resumes from its worker.
+    class CancellationToken {
+    public:
+        CancellationToken();
+        void cancel();
+        bool cancelled() const { return shared->flag.load(); }
+        const std::atomic<bool>* get() const { return &shared->flag; }
+
+        // Registers fn to run once from cancel(); false (fn not kept) if already cancelled.
+        bool on_cancel(size_t& id, std::function<void()> fn);
+        void remove(size_t id);
+
+    private:
+        struct Shared {
+            std::atomic<bool> flag{ false };
+            std::mutex mutex;
+            std::map<size_t, std::function<void()>> callbacks;
+            size_t next_id = 0;
+        };
+        std::shared_ptr<Shared> shared;
+    };
+
+    using Resumer = std::function<void(std::coroutine_handle<>)>;
+
+    class ResizeAwaitable {
+    public:
+        struct State;
+
+        explicit ResizeAwaitable(std::shared_ptr<State> state) : state(std::move(state)) {}
+
+        bool await_ready() const noexcept { return false; }
+        // False (resume immediately, await_resume throws) when the pool queue is full.
+        bool await_suspend(std::coroutine_handle<> caller);
+        Image await_resume();
+
+    private:
+        std::shared_ptr<State> state;
+    };
+
+    ResizeAwaitable resize_async(ImageView view, Pipeline::Params params,
+                                 CancellationToken cancel = CancellationToken(), Resumer resume_on = Resumer());
+
+    // Sizes the internal pool; only effective before the first resize_async call.
+    bool configure_pool(int workers, size_t queue_capacity);
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "batch.h"
+#include "jpeg_cpu.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem> // Requires C++17
+#include <iostream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace Batch {
+    std::vector<std::string> list_jpeg_files(const std::string& directory) {
+        if (!fs::exists(directory) || !fs::is_directory(directory)) {
+            throw std::runtime_error("Invalid directory: " + directory);
+        }
+
+        std::vector<std::string> files;
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            if (!entry.is_regular_file()) continue;
+            std::string ext = entry.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext == ".jpg" || ext == ".jpeg") files.push_back(entry.path().string());
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    int run(const std::string& input_dir, const std::string& output_dir,
+            const Pipeline::Params& params, const Prefetcher::Options& prefetch) {
+        using Clock = std::chrono::steady_clock;
+        auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+        std::vector<std::string> files = list_jpeg_files(input_dir);
+        fs::create_directories(output_dir);
+
+        Prefetcher prefetcher(files, prefetch);
+        std::cout << "Batch: " << files.size() << " files, read-ahead " << prefetch.depth
+                  << " via " << prefetcher.backend() << "\n";
+
+        int failures = 0;
+        double io_wait_ms = 0.0;
+        auto start = Clock::now();
+
+        std::string path;
+        std::vector<unsigned char> bytes;
+        while (true) {
+            auto wait_start = Clock::now();
+            if (!prefetcher.next(path, bytes)) break;
+            io_wait_ms += ms(Clock::now() - wait_start);
+
+            fs::path output_path = fs::path(output_dir) / fs::path(path).filename();
+            try {
+                if (bytes.empty()) throw std::runtime_error("could not read file");
+
+                std::vector<unsigned char> image_data;
+                int width = 0, height = 0, channels = 0;
+                JPEGProcessor::read_jpeg_memory(bytes, image_data, width, height, channels);
+                if (image_data.empty()) throw std::runtime_error("could not decode JPEG");
+
+                int new_width, new_height;
+                Pipeline::resolve_size(params, width, height, new_width, new_height);
+                std::vector<unsigned char> resampled = Pipeline::resample(image_data, width, height, channels, new_width, new_height, params);
+                JPEGProcessor::write_jpeg_file_parallel(output_path.string().c_str(), resampled, new_width, new_height, channels, params.quality);
+                std::cout << "Written " << output_path.string() << "\n";
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Failed " << path << ": " << e.what() << "\n";
+                ++failures;
+            }
+        }
+
+        std::cout << "Batch done in " << ms(Clock::now() - start) << " ms ("
+                  << io_wait_ms << " ms waiting on input), " << failures << " failed\n";
+        return failures;
+    }
+}
\ No newline at end of file
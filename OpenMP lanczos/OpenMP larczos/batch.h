@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "pipeline.h"
+#include "prefetch.h"
+
+// Directory batch mode: every JPEG in input_dir is resampled into output_dir under the
+// same file name. Input bytes are read ahead by a Prefetcher, so only the first file's
+// read is exposed; the rest overlap decode, resample and encode of earlier files.
+namespace Batch {
+    std::vector<std::string> list_jpeg_files(const std::string& directory);
+
+    // Returns the number of files that failed.
+    int run(const std::string& input_dir, const std::string& output_dir,
+            const Pipeline::Params& params, const Prefetcher::Options& prefetch);
+}
\ No newline at end of file
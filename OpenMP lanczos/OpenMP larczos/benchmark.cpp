@@ -0,0 +1,151 @@
+#include "benchmark.h"
+#include "jpeg_cpu.h"
+#include "pipeline.h"
+#include "lanczos.h"
+#include "adaptive.h"
+#include "perf_counters.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <omp.h>
+
+namespace Benchmark {
+    double psnr(const std::vector<unsigned char>& reference, const std::vector<unsigned char>& test) {
+        if (reference.size() != test.size() || reference.empty()) {
+            throw std::invalid_argument("PSNR needs two images of the same size");
+        }
+        double squared_error = 0.0;
+        for (size_t i = 0; i < reference.size(); ++i) {
+            double diff = static_cast<double>(reference[i]) - test[i];
+            squared_error += diff * diff;
+        }
+        if (squared_error == 0.0) return std::numeric_limits<double>::infinity();
+        double mse = squared_error / reference.size();
+        return 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+
+    int run(const std::string& input_image, float scale_factor, int runs) {
+        std::vector<unsigned char> image_data;
+        int width = 0, height = 0, channels = 0;
+        JPEGProcessor::read_jpeg_file(input_image, image_data, width, height, channels);
+        if (image_data.empty()) return 1;
+
+        Pipeline::Params params;
+        params.scale = scale_factor;
+        params.use_profile = false;
+        int new_width, new_height;
+        Pipeline::resolve_size(params, width, height, new_width, new_height);
+        runs = std::max(runs, 1);
+
+        std::cout << "Benchmark: " << width << "x" << height << " -> " << new_width << "x" << new_height
+                  << ", " << channels << " channels, " << omp_get_max_threads() << " threads, best of " << runs << "\n";
+        std::cout << std::left << std::setw(10) << "filter" << std::setw(10) << "precision" << std::setw(8) << "layout"
+                  << std::right << std::setw(12) << "time (ms)" << std::setw(12) << "Mpix/s"
+                  << std::setw(14) << "PSNR (dB)" << "  counters\n";
+        const double output_pixels = static_cast<double>(new_width) * new_height;
+
+        for (const char* filter : { "lanczos", "bicubic" }) {
+            std::vector<unsigned char> reference;
+            for (int variant = 0; variant < 4; ++variant) {
+                Precision precision = (variant < 2) ? Precision::Double : Precision::Float;
+                params.filter = filter;
+                params.precision = precision;
+                params.rgbx = (variant % 2 == 1);
+                if (params.rgbx && channels != 3) continue;
+
+                std::vector<unsigned char> output;
+                double best = std::numeric_limits<double>::max();
+                PerfCounters::Reading counters;
+                for (int r = 0; r < runs; ++r) {
+                    PerfCounters::Scope scope;
+                    output = Pipeline::resample(image_data, width, height, channels, new_width, new_height, params);
+                    counters = scope.stop();
+                    best = std::min(best, counters.seconds);
+                }
+                if (variant == 0) reference = output;
+
+                std::cout << std::left << std::setw(10) << filter << std::setw(10) << precision_name(precision)
+                          << std::setw(8) << (params.rgbx ? "rgbx" : "rgb")
+                          << std::right << std::fixed << std::setprecision(2)
+                          << std::setw(12) << best * 1000.0
+                          << std::setw(12) << (static_cast<double>(new_width) * new_height / 1e6) / best
+                          << std::setw(14) << psnr(reference, output)
+                          << "  " << PerfCounters::describe(counters, output_pixels) << "\n";
+            }
+        }
+        std::string missing = PerfCounters::unavailable_reason();
+        if (!missing.empty()) std::cout << "(some counters unavailable: " << missing << ")\n";
+
+        // Adaptive Lanczos against the uniform kernel (double, packed layout).
+        std::vector<unsigned char> uniform;
+        double uniform_time = std::numeric_limits<double>::max();
+        for (int r = 0; r < runs; ++r) {
+            double start = omp_get_wtime();
+            uniform = Lanczos::upscale(image_data, width, height, channels, new_width, new_height, params.taps);
+            uniform_time = std::min(uniform_time, omp_get_wtime() - start);
+        }
+
+        std::cout << "\nAdaptive lanczos (a=" << params.taps << " / a=2), uniform: " << std::fixed << std::setprecision(2)
+                  << uniform_time * 1000.0 << " ms\n";
+        std::cout << std::left << std::setw(10) << "threshold" << std::right << std::setw(12) << "time (ms)"
+                  << std::setw(10) << "speedup" << std::setw(12) << "cheap (%)" << std::setw(14) << "PSNR (dB)" << "\n";
+        for (int threshold : { 4, 8, 16, 32, 64 }) {
+            std::vector<unsigned char> output;
+            Adaptive::Stats stats;
+            double best = std::numeric_limits<double>::max();
+            for (int r = 0; r < runs; ++r) {
+                double start = omp_get_wtime();
+                output = Lanczos::upscale_adaptive(image_data, width, height, channels, new_width, new_height,
+                                                   params.taps, threshold, Precision::Double, EdgeMode::Clamp,
+                                                   AlphaMode::Premultiply, &stats);
+                best = std::min(best, omp_get_wtime() - start);
+            }
+            std::cout << std::left << std::setw(10) << threshold << std::right
+                      << std::setw(12) << best * 1000.0
+                      << std::setw(10) << uniform_time / best
+                      << std::setw(12) << 100.0 * stats.cheap_tiles / std::max(stats.tiles, 1)
+                      << std::setw(14) << psnr(uniform, output) << "\n";
+        }
+        return 0;
+    }
+
+    int profile(const std::string& input_image, const std::string& output_image, float scale_factor) {
+        std::vector<unsigned char> jpeg_bytes = Pipeline::read_file_bytes(input_image);
+
+        auto report = [](const char* stage, const PerfCounters::Reading& reading, double pixels) {
+            std::cout << std::left << std::setw(10) << stage << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(12) << reading.seconds * 1000.0 << "  " << PerfCounters::describe(reading, pixels) << "\n";
+        };
+
+        std::cout << std::left << std::setw(10) << "stage" << std::right << std::setw(12) << "time (ms)" << "  counters\n";
+
+        std::vector<unsigned char> image_data;
+        int width = 0, height = 0, channels = 0;
+        PerfCounters::Scope decode;
+        JPEGProcessor::read_jpeg_memory(jpeg_bytes, image_data, width, height, channels);
+        PerfCounters::Reading decoded = decode.stop();
+        if (image_data.empty()) return 1;
+        report("decode", decoded, static_cast<double>(width) * height);
+
+        Pipeline::Params params;
+        params.scale = scale_factor;
+        int new_width, new_height;
+        Pipeline::resolve_size(params, width, height, new_width, new_height);
+        const double output_pixels = static_cast<double>(new_width) * new_height;
+
+        PerfCounters::Scope resample;
+        std::vector<unsigned char> output = Pipeline::resample(image_data, width, height, channels, new_width, new_height, params);
+        report("resample", resample.stop(), output_pixels);
+
+        PerfCounters::Scope encode;
+        JPEGProcessor::write_jpeg_file_parallel(output_image, output, new_width, new_height, channels, params.quality);
+        report("encode", encode.stop(), output_pixels);
+
+        std::string missing = PerfCounters::unavailable_reason();
+        if (!missing.empty()) std::cout << "(some counters unavailable: " << missing << ")\n";
+        return 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace Benchmark {
+    // Times every filter at float and double precision, in packed RGB and padded RGBX
+    // layout, on one image and prints a table. The double RGB result of each filter is
+    // the reference for the PSNR column; hardware counters of the last run follow each row.
+    // A second table compares content-adaptive Lanczos (see adaptive.h) at several
+    // thresholds against the uniform kernel: speedup, share of cheap tiles and PSNR.
+    int run(const std::string& input_image, float scale_factor, int runs);
+
+    // Decode, resample and encode one image, reporting each stage's wall time and hardware
+    // counters (see perf_counters.h).
+    int profile(const std::string& input_image, const std::string& output_image, float scale_factor);
+
+    double psnr(const std::vector<unsigned char>& reference, const std::vector<unsigned char>& test);
+}
@@ -1,54 +1,88 @@
 #include "bicubic.h"
+#include "separable.h"
+#include "tiled_raw.h"
 #include <cmath>
 #include <algorithm>
+#include <stdexcept>
+#include <utility>
 #include <omp.h>
 
 namespace {
-    double cubic(double x) {
+    template <typename T>
+    T cubic(T x) {
         x = std::abs(x);
-        if (x <= 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
-        else if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
-        return 0.0;
+        if (x <= T(1)) return (T(1.5) * x - T(2.5)) * x * x + T(1);
+        else if (x < T(2)) return ((T(-0.5) * x + T(2.5)) * x - T(4)) * x + T(2);
+        return T(0);
+    }
+
+    template <typename T>
+    std::pair<Separable::Axis<T>, Separable::Axis<T>> build_axes(int input_width, int input_height,
+                                                                 int output_width, int output_height,
+                                                                 EdgeMode edge) {
+        auto first_tap = [](T center) { return static_cast<int>(center) - 1; };
+        auto kernel = [](T distance) { return cubic(distance); };
+
+        T x_ratio = static_cast<T>(input_width - 1) / (output_width - 1);
+        T y_ratio = static_cast<T>(input_height - 1) / (output_height - 1);
+
+        auto x_axis = Separable::build_axis<T>(input_width, output_width, 4, edge,
+            [x_ratio](int x) { return x * x_ratio; }, first_tap, kernel);
+        auto y_axis = Separable::build_axis<T>(input_height, output_height, 4, edge,
+            [y_ratio](int y) { return y * y_ratio; }, first_tap, kernel);
+
+        return { std::move(x_axis), std::move(y_axis) };
+    }
+
+    template <typename T>
+    std::vector<unsigned char> upscale_impl(const unsigned char* input, size_t row_stride,
+                                            int input_width, int input_height, int channels,
+                                            int output_width, int output_height,
+                                            EdgeMode edge, AlphaMode alpha) {
+        auto [x_axis, y_axis] = build_axes<T>(input_width, input_height, output_width, output_height, edge);
+        return Separable::resample(input, row_stride, channels, x_axis, y_axis, alpha);
+    }
+
+    template <typename T>
+    void upscale_tiled_impl(const std::vector<unsigned char>& input,
+                            int input_width, int input_height, int channels,
+                            TiledRaw& output, EdgeMode edge, AlphaMode alpha) {
+        auto [x_axis, y_axis] = build_axes<T>(input_width, input_height, output.width(), output.height(), edge);
+        Separable::resample_into(input.data(), static_cast<size_t>(input_width) * channels, channels,
+            x_axis, y_axis, alpha, output.tile_size(),
+            [&output](const Tiles::Tile& tile, int y) { return output.row(tile, y); });
     }
 }
 
 namespace Bicubic {
     std::vector<unsigned char> upscale(const std::vector<unsigned char>& input,
                                        int input_width, int input_height, int channels,
-                                       int output_width, int output_height) {
-        std::vector<unsigned char> output(output_width * output_height * channels);
-        double x_ratio = static_cast<double>(input_width - 1) / (output_width - 1);
-        double y_ratio = static_cast<double>(input_height - 1) / (output_height - 1);
-
-        #pragma omp parallel for collapse(2)
-        for (int y = 0; y < output_height; ++y) {
-            for (int x = 0; x < output_width; ++x) {
-                double x_l = x * x_ratio;
-                double y_l = y * y_ratio;
-                int x_i = static_cast<int>(x_l);
-                int y_i = static_cast<int>(y_l);
-
-                for (int c = 0; c < channels; ++c) {
-                    double result = 0.0;
-                    double normalizer = 0.0;
-
-                    for (int m = -1; m <= 2; ++m) {
-                        for (int n = -1; n <= 2; ++n) {
-                            int cur_x = std::clamp(x_i + m, 0, input_width - 1);
-                            int cur_y = std::clamp(y_i + n, 0, input_height - 1);
-                            double weight = cubic(x_l - cur_x) * cubic(y_l - cur_y);
-
-                            result += weight * input[(cur_y * input_width + cur_x) * channels + c];
-                            normalizer += weight;
-                        }
-                    }
-
-                    output[(y * output_width + x) * channels + c] = 
-                        static_cast<unsigned char>(std::clamp(result / normalizer, 0.0, 255.0));
-                }
-            }
+                                       int output_width, int output_height,
+                                       Precision precision, EdgeMode edge, AlphaMode alpha) {
+        return upscale(input.data(), static_cast<size_t>(input_width) * channels, input_width, input_height, channels,
+                       output_width, output_height, precision, edge, alpha);
+    }
+
+    std::vector<unsigned char> upscale(const unsigned char* input, size_t row_stride,
+                                       int input_width, int input_height, int channels,
+                                       int output_width, int output_height,
+                                       Precision precision, EdgeMode edge, AlphaMode alpha) {
+        if (precision == Precision::Float) {
+            return upscale_impl<float>(input, row_stride, input_width, input_height, channels, output_width, output_height, edge, alpha);
         }
+        return upscale_impl<double>(input, row_stride, input_width, input_height, channels, output_width, output_height, edge, alpha);
+    }
 
-        return output;
+    void upscale_tiled(const std::vector<unsigned char>& input,
+                       int input_width, int input_height, int channels,
+                       TiledRaw& output, Precision precision, EdgeMode edge, AlphaMode alpha) {
+        if (output.read_only()) throw std::invalid_argument("Tiled output is read-only");
+        if (output.channels() != channels) throw std::invalid_argument("Tiled output channel count does not match input");
+        if (precision == Precision::Float) {
+            upscale_tiled_impl<float>(input, input_width, input_height, channels, output, edge, alpha);
+        }
+        else {
+            upscale_tiled_impl<double>(input, input_width, input_height, channels, output, edge, alpha);
+        }
     }
 }
\ No newline at end of file
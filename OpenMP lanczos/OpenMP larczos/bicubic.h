@@ -1,8 +1,31 @@
 #pragma once
+#include <cstddef>
 #include <vector>
+#include "precision.h"
+#include "edge_mode.h"
+#include "pixel_format.h"
+
+class TiledRaw;
 
 namespace Bicubic {
     std::vector<unsigned char> upscale(const std::vector<unsigned char>& input,
                                        int input_width, int input_height, int channels,
-                                       int output_width, int output_height);
+                                       int output_width, int output_height,
+                                       Precision precision = Precision::Double,
+                                       EdgeMode edge = EdgeMode::Clamp,
+                                       AlphaMode alpha = AlphaMode::Premultiply);
+
+    // Same, reading a borrowed buffer in place; rows start row_stride bytes apart.
+    std::vector<unsigned char> upscale(const unsigned char* input, size_t row_stride,
+                                       int input_width, int input_height, int channels,
+                                       int output_width, int output_height,
+                                       Precision precision = Precision::Double,
+                                       EdgeMode edge = EdgeMode::Clamp,
+                                       AlphaMode alpha = AlphaMode::Premultiply);
+
+    void upscale_tiled(const std::vector<unsigned char>& input,
+                       int input_width, int input_height, int channels,
+                       TiledRaw& output, Precision precision = Precision::Double,
+                       EdgeMode edge = EdgeMode::Clamp,
+                       AlphaMode alpha = AlphaMode::Premultiply);
 }
\ No newline at end of file
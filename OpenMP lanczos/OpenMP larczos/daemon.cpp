@@ -0,0 +1,383 @@
+#include "daemon.h"
+#include "admission.h"
+#include "jpeg_cpu.h"
+#include "pipeline.h"
+#include "result_cache.h"
+#include "multi_target.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Keeps the most recent latencies in a ring so percentiles track current load.
+    class LatencyStats {
+    public:
+        void record(double ms, bool ok) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (samples.size() < window) samples.push_back(ms);
+            else samples[next % window] = ms;
+            ++next;
+            if (ok) ++completed; else ++failed;
+        }
+
+        std::string report(size_t queued, int active, int workers) const {
+            std::vector<double> sorted;
+            size_t done, errors;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                sorted = samples;
+                done = completed;
+                errors = failed;
+            }
+            std::sort(sorted.begin(), sorted.end());
+
+            std::ostringstream out;
+            out << "queue_depth=" << queued << "\n"
+                << "active=" << active << "\n"
+                << "workers=" << workers << "\n"
+                << "completed=" << done << "\n"
+                << "failed=" << errors << "\n";
+            for (double p : { 50.0, 90.0, 99.0 }) {
+                double value = 0.0;
+                if (!sorted.empty()) {
+                    size_t rank = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+                    value = sorted[rank];
+                }
+                out << "latency_p" << static_cast<int>(p) << "_ms=" << value << "\n";
+            }
+            return out.str();
+        }
+
+    private:
+        static constexpr size_t window = 1024;
+        std::vector<double> samples;
+        size_t next = 0;
+        size_t completed = 0;
+        size_t failed = 0;
+        mutable std::mutex mutex;
+    };
+
+#ifndef _WIN32
+    struct Request {
+        std::map<std::string, std::string> fields;
+        std::vector<unsigned char> payload;
+    };
+
+    // Limits for what one client may send; a longer upload should use input=<path>.
+    constexpr size_t max_header_bytes = 64 * 1024;
+    constexpr size_t max_payload_bytes = size_t(256) << 20;
+    // Per-read timeout, so a client that connects and stalls cannot hold a reader for long.
+    constexpr int request_timeout_seconds = 5;
+    // Requests are read off the accept thread by this many readers, which then queue the
+    // resize itself on the worker pool; a slow upload only ties up one reader.
+    constexpr int reader_threads = 4;
+
+    // False when the client disconnected or timed out; throws on a malformed request.
+    bool read_request(int fd, Request& request) {
+        std::string header;
+        char buffer[4096];
+        size_t header_end = std::string::npos;
+
+        while (header_end == std::string::npos) {
+            if (header.size() > max_header_bytes) throw std::invalid_argument("request header too large");
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n <= 0) return false;
+            header.append(buffer, static_cast<size_t>(n));
+            header_end = header.find("\n\n");
+        }
+
+        std::istringstream lines(header.substr(0, header_end));
+        std::string line;
+        while (std::getline(lines, line)) {
+            size_t eq = line.find('=');
+            if (eq != std::string::npos) request.fields[line.substr(0, eq)] = line.substr(eq + 1);
+        }
+
+        auto length = request.fields.find("length");
+        if (length != request.fields.end()) {
+            const std::string& text = length->second;
+            if (text.empty() || text.size() > 12 || text.find_first_not_of("0123456789") != std::string::npos) {
+                throw std::invalid_argument("invalid length");
+            }
+            size_t expected = std::stoull(text);
+            if (expected > max_payload_bytes) throw std::invalid_argument("length exceeds " + std::to_string(max_payload_bytes) + " bytes");
+            request.payload.assign(header.begin() + header_end + 2, header.end());
+            request.payload.reserve(expected);
+            while (request.payload.size() < expected) {
+                ssize_t n = read(fd, buffer, std::min(sizeof(buffer), expected - request.payload.size()));
+                if (n <= 0) return false;
+                request.payload.insert(request.payload.end(), buffer, buffer + n);
+            }
+        }
+        return true;
+    }
+
+    void write_all(int fd, const std::string& text) {
+        size_t sent = 0;
+        while (sent < text.size()) {
+            ssize_t n = write(fd, text.data() + sent, text.size() - sent);
+            if (n <= 0) return;
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    // libjpeg rejects larger frames; catch that before any work is queued.
+    void check_output_size(int width, int height) {
+        if (width > JPEGProcessor::max_dimension() || height > JPEGProcessor::max_dimension()) {
+            throw std::invalid_argument("output size " + std::to_string(width) + "x" + std::to_string(height)
+                                        + " exceeds the JPEG limit of " + std::to_string(JPEGProcessor::max_dimension()));
+        }
+    }
+
+    Pipeline::Params parse_params(const std::map<std::string, std::string>& fields) {
+        Pipeline::Params params;
+        for (const auto& [key, value] : fields) {
+            if (key == "width") params.output_width = std::stoi(value);
+            else if (key == "height") params.output_height = std::stoi(value);
+            else if (key == "scale") params.scale = std::stof(value);
+            else if (key == "filter") params.filter = value;
+            else if (key == "taps") params.taps = std::stoi(value);
+            else if (key == "quality") params.quality = std::stoi(value);
+            else if (key == "precision") params.precision = parse_precision(value);
+            else if (key == "edge") params.edge = parse_edge_mode(value);
+            else if (key == "layout") params.rgbx = (value == "rgbx");
+            else if (key == "adaptive") params.adaptive_threshold = std::stoi(value);
+        }
+        // Unknown filters would otherwise be admitted and hold budget before the pipeline rejects them.
+        if (params.filter != "lanczos" && params.filter != "bicubic") throw std::invalid_argument("unknown filter: " + params.filter);
+        if (params.output_width < 0 || params.output_height < 0) throw std::invalid_argument("negative output size");
+        check_output_size(params.output_width, params.output_height);
+        if (!(params.scale >= 0.0f && params.scale <= JPEGProcessor::max_dimension())) throw std::invalid_argument("invalid scale");
+        if (params.taps < 1 || params.taps > 16) throw std::invalid_argument("taps must be in 1..16");
+        if (params.quality < 1 || params.quality > 100) throw std::invalid_argument("quality must be in 1..100");
+        return params;
+    }
+
+    std::vector<int> parse_widths(const std::string& width_list) {
+        std::vector<int> widths;
+        std::stringstream list(width_list);
+        std::string item;
+        while (std::getline(list, item, ',')) widths.push_back(std::stoi(item));
+        return widths;
+    }
+
+    // One decode, several widths; output= is used as the file name prefix.
+    std::string run_multi(const std::vector<unsigned char>& jpeg_bytes, const std::vector<int>& widths,
+                          const std::string& output_prefix, const Pipeline::Params& params) {
+        std::vector<unsigned char> image_data;
+        int width = 0, height = 0, channels = 0;
+        JPEGProcessor::read_jpeg_memory(jpeg_bytes, image_data, width, height, channels);
+        if (image_data.empty()) throw std::runtime_error("could not decode input");
+
+        std::string reply = "OK";
+        auto targets = MultiTarget::from_widths(widths, width, height, output_prefix);
+        for (const auto& result : MultiTarget::run(image_data, width, height, channels, targets, params)) {
+            reply += " " + std::to_string(result.width) + "x" + std::to_string(result.height);
+        }
+        return reply;
+    }
+
+    std::string run_resize(const Request& request, ResultCache* cache, Admission::Budget& budget) {
+        auto output = request.fields.find("output");
+        if (output == request.fields.end()) throw std::invalid_argument("missing output");
+        Pipeline::Params params = parse_params(request.fields);
+
+        std::vector<unsigned char> file_bytes;
+        auto input = request.fields.find("input");
+        if (request.payload.empty()) {
+            if (input == request.fields.end()) throw std::invalid_argument("missing input or length");
+            file_bytes = Pipeline::read_file_bytes(input->second);
+        }
+        const std::vector<unsigned char>& jpeg_bytes = request.payload.empty() ? file_bytes : request.payload;
+
+        // Sizes come from the header so the job is admitted before anything is decoded.
+        Admission::Job job;
+        if (!JPEGProcessor::read_jpeg_header(jpeg_bytes, job.input_width, job.input_height, job.channels)) {
+            throw std::runtime_error("could not decode input");
+        }
+        job.compressed_bytes = jpeg_bytes.size();
+
+        auto widths = request.fields.find("widths");
+        if (widths != request.fields.end()) {
+            std::vector<int> list = parse_widths(widths->second);
+            for (const auto& target : MultiTarget::from_widths(list, job.input_width, job.input_height, output->second)) {
+                check_output_size(target.width, target.height);
+                job.outputs.emplace_back(target.width, target.height);
+            }
+            Admission::Budget::Ticket ticket = budget.admit(job, params);
+            return run_multi(jpeg_bytes, list, output->second, params);
+        }
+
+        std::string cache_key;
+        if (cache) {
+            cache_key = cache->key(jpeg_bytes, params);
+            if (cache->fetch(cache_key, output->second)) return "OK cached";
+        }
+
+        int new_width, new_height;
+        Pipeline::resolve_size(params, job.input_width, job.input_height, new_width, new_height);
+        check_output_size(new_width, new_height);
+        job.outputs.emplace_back(new_width, new_height);
+        Admission::Budget::Ticket ticket = budget.admit(job, params);
+
+        std::vector<unsigned char> image_data;
+        int width = 0, height = 0, channels = 0;
+        JPEGProcessor::read_jpeg_memory(jpeg_bytes, image_data, width, height, channels);
+        if (image_data.empty()) throw std::runtime_error("could not decode input");
+
+        std::string size = std::to_string(new_width) + "x" + std::to_string(new_height);
+        if (ticket.mode() == Admission::Mode::Streamed) {
+            Pipeline::resample_streamed(image_data, width, height, channels, new_width, new_height, params, output->second);
+            if (cache) cache->store(cache_key, output->second);
+            return "OK " + size + " streamed";
+        }
+
+        std::vector<unsigned char> resized = Pipeline::resample(image_data, width, height, channels, new_width, new_height, params);
+        JPEGProcessor::write_jpeg_file_parallel(output->second, resized, new_width, new_height, channels, params.quality);
+        if (cache) cache->store(cache_key, output->second);
+
+        return "OK " + size;
+    }
+#endif
+}
+
+namespace ResizeDaemon {
+#ifdef _WIN32
+    int serve(const Options&) {
+        std::cerr << "Daemon mode requires Unix domain sockets and is not supported on this platform.\n";
+        return 1;
+    }
+#else
+    int serve(const Options& options) {
+        std::signal(SIGPIPE, SIG_IGN);
+
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0) {
+            std::cerr << "Error creating socket\n";
+            return 1;
+        }
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (options.socket_path.size() >= sizeof(address.sun_path)) {
+            std::cerr << "Socket path too long: " << options.socket_path << "\n";
+            close(listener);
+            return 1;
+        }
+        std::copy(options.socket_path.begin(), options.socket_path.end(), address.sun_path);
+        unlink(options.socket_path.c_str());
+
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 64) < 0) {
+            std::cerr << "Error binding socket: " << options.socket_path << "\n";
+            close(listener);
+            return 1;
+        }
+
+        LatencyStats stats;
+        std::unique_ptr<ResultCache> cache = ResultCache::from_environment();
+        size_t memory_budget = options.memory_budget;
+        if (memory_budget == 0) {
+            memory_budget = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<size_t>(sysconf(_SC_PAGE_SIZE)) / 2;
+        }
+        // Declared before the pools, which still run queued jobs against it while shutting down.
+        Admission::Budget budget(memory_budget, std::max(options.workers, 1));
+        std::atomic<bool> stopping(false);
+        {
+            WorkerPool pool(options.workers, options.queue_capacity);
+            auto handle = [listener, &stopping, &stats, &cache, &budget, &pool](int client) {
+                timeval timeout{};
+                timeout.tv_sec = request_timeout_seconds;
+                setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+                auto request = std::make_shared<Request>();
+                try {
+                    if (!read_request(client, *request)) {
+                        close(client);
+                        return;
+                    }
+                }
+                catch (const std::exception& e) {
+                    write_all(client, std::string("ERR ") + e.what() + "\n");
+                    close(client);
+                    return;
+                }
+
+                const std::string& command = request->fields["command"];
+                if (command == "shutdown") {
+                    write_all(client, "OK shutting down\n");
+                    close(client);
+                    // Wakes the accept loop; the listener stays open until the readers are joined.
+                    if (!stopping.exchange(true)) ::shutdown(listener, SHUT_RDWR);
+                    return;
+                }
+                if (command == "stats") {
+                    write_all(client, stats.report(pool.queued(), pool.active(), pool.workers()) + budget.report());
+                    close(client);
+                    return;
+                }
+                if (command != "resize") {
+                    write_all(client, "ERR unknown command\n");
+                    close(client);
+                    return;
+                }
+
+                // Blocks while the queue is full, which in turn stalls the readers and the accept loop.
+                auto enqueued = Clock::now();
+                pool.submit([client, request, enqueued, &stats, &cache, &budget] {
+                    std::string reply;
+                    bool ok = true;
+                    try {
+                        reply = run_resize(*request, cache.get(), budget);
+                    }
+                    catch (const std::exception& e) {
+                        reply = std::string("ERR ") + e.what();
+                        ok = false;
+                    }
+                    double ms = std::chrono::duration<double, std::milli>(Clock::now() - enqueued).count();
+                    stats.record(ms, ok);
+                    write_all(client, reply + (ok ? " " + std::to_string(ms) + "ms" : "") + "\n");
+                    close(client);
+                });
+            };
+
+            // Declared last so queued reads finish (and may still submit) before anything above goes.
+            WorkerPool readers(reader_threads, options.queue_capacity);
+            std::cout << "Listening on " << options.socket_path << " with " << pool.workers() << " workers and a "
+                      << (memory_budget >> 20) << " MB memory budget.\n";
+
+            // The accept loop only hands sockets off, so one slow client cannot hold up the rest.
+            while (!stopping.load()) {
+                int client = accept(listener, nullptr, nullptr);
+                if (client < 0) continue;
+                if (stopping.load()) {
+                    close(client);
+                    break;
+                }
+                readers.submit([client, &handle] { handle(client); });
+            }
+        }
+
+        close(listener);
+        unlink(options.socket_path.c_str());
+        return 0;
+    }
+#endif
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Long-running resize server on a Unix domain socket.
+//
+// Each connection carries one request: "key=value" lines terminated by an empty line.
+//   command=resize  input=<path> | length=<n>  output=<path>
+//                   [width=<w>] [height=<h>] [scale=<s>] [filter=lanczos|bicubic] [taps=<a>] [quality=<q>]
+//                   [precision=float|double] [edge=clamp|reflect|wrap]
+//                   [layout=rgb|rgbx] [adaptive=<gradient threshold>]
+//                   [widths=<w1,w2,...>]   (one decode, output= becomes a prefix: <output>_<w>x<h>.jpg)
+//   command=stats
+//   command=shutdown   (finishes queued jobs, then exits)
+// With length=<n>, exactly n bytes of JPEG data follow the empty line instead of an input path.
+// The reply is a single "OK ..." or "ERR ..." line (stats replies with several key=value lines).
+//
+// Resize jobs are admitted against a global memory budget (see admission.h); a job too
+// large for its share is encoded through a temporary tiled file and replies "OK ... streamed".
+namespace ResizeDaemon {
+    struct Options {
+        std::string socket_path;
+        int workers = 2;
+        size_t queue_capacity = 16;
+        size_t memory_budget = 0; // bytes; 0 = half the physical memory
+    };
+
+    int serve(const Options& options);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+
+// How taps that fall outside the source image are mapped back inside it.
+//   Clamp:   repeat the edge pixel      aaa|abcd|ddd
+//   Reflect: mirror about the edge      cba|abcd|dcb... (edge pixel repeated once)
+//   Wrap:    tile the image             bcd|abcd|abc
+enum class EdgeMode { Clamp, Reflect, Wrap };
+
+inline EdgeMode parse_edge_mode(const std::string& name) {
+    if (name == "clamp") return EdgeMode::Clamp;
+    if (name == "reflect") return EdgeMode::Reflect;
+    if (name == "wrap") return EdgeMode::Wrap;
+    throw std::invalid_argument("Unknown edge mode: " + name);
+}
+
+inline const char* edge_mode_name(EdgeMode mode) {
+    switch (mode) {
+    case EdgeMode::Reflect: return "reflect";
+    case EdgeMode::Wrap: return "wrap";
+    default: return "clamp";
+    }
+}
+
+inline int resolve_edge(int i, int n, EdgeMode mode) {
+    if (i >= 0 && i < n) return i;
+    switch (mode) {
+    case EdgeMode::Reflect: {
+        int period = 2 * n;
+        i %= period;
+        if (i < 0) i += period;
+        return (i < n) ? i : period - 1 - i;
+    }
+    case EdgeMode::Wrap:
+        i %= n;
+        return (i < 0) ? i + n : i;
+    default:
+        return (i < 0) ? 0 : n - 1;
+    }
+}
\ No newline at end of file
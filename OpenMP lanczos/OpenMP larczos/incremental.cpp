@@ -0,0 +1,112 @@
+#include "incremental.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    std::pair<int, int> output_size(const Pipeline::Params& params, int input_width, int input_height) {
+        std::pair<int, int> size;
+        Pipeline::resolve_size(params, input_width, input_height, size.first, size.second);
+        return size;
+    }
+
+    long long area(const Tiles::Tile& tile) {
+        return static_cast<long long>(tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+    }
+}
+
+IncrementalResampler::IncrementalResampler(int input_width, int input_height, int channels,
+                                           const Pipeline::Params& params, double full_threshold, int block_size)
+    : input_width(input_width), input_height(input_height), input_channels(channels),
+      width(output_size(params, input_width, input_height).first),
+      height(output_size(params, input_width, input_height).second),
+      params(params), full_threshold(full_threshold), block_size(std::max(block_size, 1)),
+      plan(input_width, input_height, width, height, params.taps, params.precision, params.edge),
+      encoder(width, height, channels, params.quality),
+      current_output(static_cast<size_t>(width) * height * channels) {}
+
+std::vector<Tiles::Tile> IncrementalResampler::detect_changes(const std::vector<unsigned char>& frame) const {
+    const int columns = (input_width + block_size - 1) / block_size;
+    const size_t stride = static_cast<size_t>(input_width) * input_channels;
+
+    // Runs of changed blocks per block row; a run identical to one in the previous block
+    // row extends that rectangle downwards instead of starting a new one.
+    std::vector<Tiles::Tile> rects;
+    std::vector<size_t> open;
+    for (int y0 = 0; y0 < input_height; y0 += block_size) {
+        const int y1 = std::min(y0 + block_size, input_height);
+        std::vector<char> changed(columns, 0);
+        for (int bx = 0; bx < columns; ++bx) {
+            const size_t offset = static_cast<size_t>(bx) * block_size * input_channels;
+            const size_t bytes = static_cast<size_t>(std::min(block_size, input_width - bx * block_size)) * input_channels;
+            for (int y = y0; y < y1 && !changed[bx]; ++y)
+                changed[bx] = std::memcmp(&frame[y * stride + offset], &previous_input[y * stride + offset], bytes) != 0;
+        }
+
+        std::vector<size_t> next;
+        for (int bx = 0; bx < columns;) {
+            if (!changed[bx]) { ++bx; continue; }
+            int end = bx;
+            while (end < columns && changed[end]) ++end;
+            const int x0 = bx * block_size, x1 = std::min(end * block_size, input_width);
+            auto match = std::find_if(open.begin(), open.end(), [&](size_t i) {
+                return rects[i].x0 == x0 && rects[i].x1 == x1;
+            });
+            if (match != open.end()) {
+                rects[*match].y1 = y1;
+                next.push_back(*match);
+            } else {
+                rects.push_back({x0, y0, x1, y1});
+                next.push_back(rects.size() - 1);
+            }
+            bx = end;
+        }
+        open = std::move(next);
+    }
+    return rects;
+}
+
+const std::vector<Tiles::Tile>& IncrementalResampler::update(const std::vector<unsigned char>& frame,
+                                                             const std::vector<Tiles::Tile>* changed) {
+    if (frame.size() != static_cast<size_t>(input_width) * input_height * input_channels)
+        throw std::invalid_argument("IncrementalResampler: frame size does not match");
+
+    regions.clear();
+    last_stats = Stats();
+    const Tiles::Tile whole{0, 0, width, height};
+
+    bool full = !has_frame;
+    if (has_frame) {
+        const std::vector<Tiles::Tile> detected = changed ? std::vector<Tiles::Tile>() : detect_changes(frame);
+        long long covered = 0;
+        for (const Tiles::Tile& rect : changed ? *changed : detected) {
+            Tiles::Tile region = plan.affected(rect);
+            if (region.x1 <= region.x0 || region.y1 <= region.y0) continue;
+            regions.push_back(region);
+            covered += area(region);
+        }
+        full = covered > full_threshold * area(whole);
+        last_stats.recomputed = static_cast<double>(covered) / area(whole);
+    }
+    if (full) {
+        regions.assign(1, whole);
+        last_stats.full = true;
+        last_stats.recomputed = 1.0;
+    }
+
+    for (const Tiles::Tile& region : regions) {
+        plan.run(frame, input_channels, current_output, region, params.alpha);
+        unencoded_rows.emplace_back(region.y0, region.y1);
+    }
+    last_stats.regions = static_cast<int>(regions.size());
+
+    previous_input = frame;
+    has_frame = true;
+    return regions;
+}
+
+std::vector<unsigned char> IncrementalResampler::encode() {
+    std::vector<unsigned char> jpeg = encoder.encode(current_output, unencoded_rows);
+    unencoded_rows.clear();
+    return jpeg;
+}
\ No newline at end of file
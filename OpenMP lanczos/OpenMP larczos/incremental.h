@@ -0,0 +1,61 @@
+#pragma once
+#include <memory>
+#include <utility>
+#include <vector>
+#include "jpeg_cpu.h"
+#include "lanczos.h"
+#include "pipeline.h"
+#include "tiles.h"
+
+// Frame-sequence resampling (screen captures, slideshows) where consecutive frames differ
+// in small regions.
+//
+// The previous input and output are kept. Each changed source rectangle, either given by
+// the caller or found by comparing blocks against the previous frame, is mapped to the
+// output pixels whose kernel footprint reads it, and only those are recomputed with the
+// full Lanczos kernel (params.taps, precision, edge and alpha; filter is ignored). When
+// the recomputed area would exceed `full_threshold` of the output, the whole frame is
+// resampled instead. encode() likewise re-encodes only the JPEG strips that changed.
+class IncrementalResampler {
+public:
+    struct Stats {
+        bool full = false;            // last update resampled the whole frame
+        int regions = 0;              // output rectangles recomputed
+        double recomputed = 0.0;      // fraction of the output area recomputed
+    };
+
+    IncrementalResampler(int input_width, int input_height, int channels,
+                         const Pipeline::Params& params, double full_threshold = 0.5, int block_size = 32);
+
+    // Takes the next frame (same size and channels) and returns the recomputed output
+    // rectangles.
+    const std::vector<Tiles::Tile>& update(const std::vector<unsigned char>& frame,
+                                           const std::vector<Tiles::Tile>* changed = nullptr);
+
+    // JPEG of the current output; strips untouched since the previous call are reused.
+    std::vector<unsigned char> encode();
+
+    const std::vector<unsigned char>& output() const { return current_output; }
+    int output_width() const { return width; }
+    int output_height() const { return height; }
+    int channels() const { return input_channels; }
+    const Stats& stats() const { return last_stats; }
+
+private:
+    std::vector<Tiles::Tile> detect_changes(const std::vector<unsigned char>& frame) const;
+
+    int input_width, input_height, input_channels;
+    int width = 0, height = 0;
+    Pipeline::Params params;
+    double full_threshold;
+    int block_size;
+
+    Lanczos::Plan plan;
+    JPEGStripCache encoder;
+    bool has_frame = false;
+    std::vector<unsigned char> previous_input;
+    std::vector<unsigned char> current_output;
+    std::vector<Tiles::Tile> regions;
+    std::vector<std::pair<int, int>> unencoded_rows;
+    Stats last_stats;
+};
\ No newline at end of file
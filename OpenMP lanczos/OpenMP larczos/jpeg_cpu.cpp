@@ -1,6 +1,208 @@
 #include "jpeg_cpu.h"
 #include <jpeglib.h>
 #include <iostream>
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <omp.h>
+
+namespace {
+    // Error manager that returns control to the caller instead of exiting, so one corrupt
+    // buffer in a batch or daemon does not take the whole process down.
+    // Encoders turn the saved message into a std::runtime_error after the longjmp.
+    struct RecoverableError {
+        jpeg_error_mgr pub;
+        std::jmp_buf jump;
+        char message[JMSG_LENGTH_MAX];
+    };
+
+    void recoverable_error_exit(j_common_ptr cinfo) {
+        RecoverableError* error = reinterpret_cast<RecoverableError*>(cinfo->err);
+        (*cinfo->err->format_message)(cinfo, error->message);
+        std::cerr << error->message << std::endl;
+        std::longjmp(error->jump, 1);
+    }
+
+    // libjpeg cannot convert CMYK/YCCK to RGB, and passing the four ink channels on would
+    // have them resampled as RGBA and written back as RGBX, i.e. wrong colours.
+    bool decodes_to_rgb(const jpeg_decompress_struct& cinfo) {
+        return cinfo.jpeg_color_space != JCS_CMYK && cinfo.jpeg_color_space != JCS_YCCK;
+    }
+
+    FILE* open_output(const std::string& filename) {
+        FILE* outfile = nullptr;
+        fopen_s(&outfile, filename.c_str(), "wb");
+        if (!outfile) throw std::runtime_error("Error opening output file: " + filename);
+        return outfile;
+    }
+
+    // JPEG has no alpha, so 4-channel RGBX/RGBA buffers are written as RGB. libjpeg-turbo
+    // reads the padded layout directly; plain libjpeg gets each row repacked to RGB.
+    void configure_compress(jpeg_compress_struct& cinfo, int width, int height, int channels, int quality) {
+        cinfo.image_width = width;
+        cinfo.image_height = height;
+        if (channels == 4) {
+#ifdef JCS_EXTENSIONS
+            cinfo.input_components = 4;
+            cinfo.in_color_space = JCS_EXT_RGBX;
+#else
+            cinfo.input_components = 3;
+            cinfo.in_color_space = JCS_RGB;
+#endif
+        }
+        else {
+            cinfo.input_components = channels;
+            cinfo.in_color_space = (channels == 3) ? JCS_RGB : JCS_GRAYSCALE;
+        }
+
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+    }
+
+    // Scratch row for write_scanlines. Callers allocate it before their setjmp, since a
+    // longjmp out of libjpeg must not skip destructors.
+    std::vector<unsigned char> packing_buffer(int width, int channels) {
+        return std::vector<unsigned char>(channels == 4 ? static_cast<size_t>(width) * 3 : 0);
+    }
+
+    // Writes scanlines up to end_row (the whole image by default); `rows` starts at image
+    // row first_row.
+    void write_scanlines(jpeg_compress_struct& cinfo, const unsigned char* rows, int width, int channels,
+                         std::vector<unsigned char>& packed, int first_row = 0, int end_row = -1) {
+        int row_stride = width * channels;
+        JDIMENSION end = end_row < 0 ? cinfo.image_height : std::min<JDIMENSION>(end_row, cinfo.image_height);
+        const bool repack = channels == 4 && cinfo.input_components == 3;
+
+        while (cinfo.next_scanline < end) {
+            const unsigned char* row_pointer = rows + static_cast<size_t>(cinfo.next_scanline - first_row) * row_stride;
+            if (repack) {
+                for (int x = 0; x < width; ++x) {
+                    packed[x * 3 + 0] = row_pointer[x * 4 + 0];
+                    packed[x * 3 + 1] = row_pointer[x * 4 + 1];
+                    packed[x * 3 + 2] = row_pointer[x * 4 + 2];
+                }
+                row_pointer = packed.data();
+            }
+            jpeg_write_scanlines(&cinfo, const_cast<JSAMPARRAY>(&row_pointer), 1);
+        }
+    }
+
+    // Height in pixels of one MCU row for the default sampling factors
+    // (16 for 4:2:0 colour, 8 for grayscale).
+    int mcu_row_height(int channels, int quality) {
+        struct jpeg_compress_struct cinfo;
+        struct jpeg_error_mgr jerr;
+
+        cinfo.err = jpeg_std_error(&jerr);
+        jpeg_create_compress(&cinfo);
+        configure_compress(cinfo, 1, 1, channels, quality);
+
+        int max_v_samp = 1;
+        for (int i = 0; i < cinfo.num_components; ++i) {
+            max_v_samp = std::max(max_v_samp, cinfo.comp_info[i].v_samp_factor);
+        }
+        jpeg_destroy_compress(&cinfo);
+        return max_v_samp * DCTSIZE;
+    }
+
+    // The restart interval is one MCU row (at least 8 pixels wide per MCU), which always
+    // fits the 16-bit DRI field for the widths libjpeg accepts.
+    static_assert(JPEG_MAX_DIMENSION / 8 + 1 <= 65535, "an MCU row must fit the DRI field");
+
+    // Encodes rows as a standalone JPEG with a restart marker after every MCU row.
+    std::vector<unsigned char> encode_strip(const unsigned char* rows, int width, int height, int channels, int quality) {
+        struct jpeg_compress_struct cinfo;
+        RecoverableError jerr;
+        std::vector<unsigned char> packed = packing_buffer(width, channels);
+
+        unsigned char* buffer = nullptr;
+        unsigned long size = 0;
+
+        cinfo.err = jpeg_std_error(&jerr.pub);
+        jerr.pub.error_exit = recoverable_error_exit;
+        if (setjmp(jerr.jump)) {
+            jpeg_destroy_compress(&cinfo);
+            std::free(buffer);
+            throw std::runtime_error(std::string("JPEG encode failed: ") + jerr.message);
+        }
+        jpeg_create_compress(&cinfo);
+        jpeg_mem_dest(&cinfo, &buffer, &size);
+
+        configure_compress(cinfo, width, height, channels, quality);
+        cinfo.restart_in_rows = 1;
+
+        jpeg_start_compress(&cinfo, TRUE);
+        write_scanlines(cinfo, rows, width, channels, packed);
+
+        jpeg_finish_compress(&cinfo);
+        jpeg_destroy_compress(&cinfo);
+
+        std::vector<unsigned char> encoded(buffer, buffer + size);
+        std::free(buffer);
+        return encoded;
+    }
+
+    // Offset of the first entropy-coded byte (just past the SOS segment). Also reports
+    // where the SOF segment starts so the frame height can be patched.
+    size_t find_scan_data(const std::vector<unsigned char>& jpeg, size_t& sof_offset) {
+        size_t pos = 2; // skip SOI
+        while (pos + 4 <= jpeg.size()) {
+            unsigned char marker = jpeg[pos + 1];
+            size_t length = (static_cast<size_t>(jpeg[pos + 2]) << 8) | jpeg[pos + 3];
+            if (marker == 0xC0) sof_offset = pos;
+            if (marker == 0xDA) return pos + 2 + length;
+            pos += 2 + length;
+        }
+        return jpeg.size();
+    }
+
+    // Joins strips from encode_strip into one baseline JPEG of the given total height.
+    std::vector<unsigned char> stitch_strips(const std::vector<std::vector<unsigned char>>& encoded, int height) {
+        const size_t strips = encoded.size();
+
+        // Headers (including DRI) come from the first strip with the frame height patched
+        // to the full image. Each strip's scan data already starts with reset DC predictors
+        // and ends byte-aligned, so strips can be joined with a restart marker; markers
+        // are renumbered so RST0-7 keep cycling across strip boundaries.
+        size_t sof_offset = 0;
+        size_t header_size = find_scan_data(encoded[0], sof_offset);
+
+        std::vector<unsigned char> output(encoded[0].begin(), encoded[0].begin() + header_size);
+        output[sof_offset + 5] = static_cast<unsigned char>(height >> 8);
+        output[sof_offset + 6] = static_cast<unsigned char>(height & 0xFF);
+
+        size_t total_size = header_size;
+        for (const auto& strip : encoded) total_size += strip.size();
+        output.reserve(total_size);
+
+        int restart_count = 0;
+        for (size_t i = 0; i < strips; ++i) {
+            const std::vector<unsigned char>& strip = encoded[i];
+            size_t unused = 0;
+            size_t begin = (i == 0) ? header_size : find_scan_data(strip, unused);
+            size_t end = strip.size() - 2; // drop EOI
+
+            for (size_t j = begin; j < end; ++j) {
+                output.push_back(strip[j]);
+                if (strip[j] == 0xFF && j + 1 < end && strip[j + 1] >= 0xD0 && strip[j + 1] <= 0xD7) {
+                    output.push_back(static_cast<unsigned char>(0xD0 + (restart_count++ & 7)));
+                    ++j;
+                }
+            }
+
+            if (i + 1 < strips) {
+                output.push_back(0xFF);
+                output.push_back(static_cast<unsigned char>(0xD0 + (restart_count++ & 7)));
+            }
+        }
+        output.push_back(0xFF);
+        output.push_back(0xD9);
+        return output;
+    }
+}
 
 void JPEGProcessor::read_jpeg_file(const std::string& filename, std::vector<unsigned char>& image_data, int& width, int& height, int& channels) {
     struct jpeg_decompress_struct cinfo;
@@ -18,6 +220,13 @@ void JPEGProcessor::read_jpeg_file(const std::string& filename, std::vector<unsi
     jpeg_stdio_src(&cinfo, infile);
 
     jpeg_read_header(&cinfo, TRUE);
+    if (!decodes_to_rgb(cinfo)) {
+        std::cerr << "Unsupported CMYK/YCCK JPEG: " << filename << std::endl;
+        jpeg_destroy_decompress(&cinfo);
+        fclose(infile);
+        image_data.clear();
+        return;
+    }
     jpeg_start_decompress(&cinfo);
 
     width = cinfo.output_width;
@@ -37,38 +246,245 @@ void JPEGProcessor::read_jpeg_file(const std::string& filename, std::vector<unsi
     fclose(infile);
 }
 
-void JPEGProcessor::write_jpeg_file(const std::string& filename, const std::vector<unsigned char>& image_data, int width, int height, int channels, int quality) {
-    struct jpeg_compress_struct cinfo;
-    struct jpeg_error_mgr jerr;
+void JPEGProcessor::read_jpeg_memory(const std::vector<unsigned char>& jpeg_data, std::vector<unsigned char>& image_data, int& width, int& height, int& channels, int scale_denom) {
+    struct jpeg_decompress_struct cinfo;
+    RecoverableError jerr;
 
-    FILE* outfile;
-    fopen_s(&outfile, filename.c_str(), "wb");
-    if (!outfile) {
-        std::cerr << "Error opening output file: " << filename << std::endl;
+    if (jpeg_data.empty()) {
+        std::cerr << "Error decoding input: empty buffer" << std::endl;
         return;
     }
 
-    cinfo.err = jpeg_std_error(&jerr);
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = recoverable_error_exit;
+    if (setjmp(jerr.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        image_data.clear();
+        return;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, jpeg_data.data(), static_cast<unsigned long>(jpeg_data.size()));
+
+    jpeg_read_header(&cinfo, TRUE);
+    if (!decodes_to_rgb(cinfo)) {
+        std::cerr << "Error decoding input: unsupported CMYK/YCCK JPEG" << std::endl;
+        jpeg_destroy_decompress(&cinfo);
+        image_data.clear();
+        return;
+    }
+    // DCT-domain downscale (1/2, 1/4, 1/8): skips most of the IDCT work.
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = scale_denom;
+    jpeg_start_decompress(&cinfo);
+
+    width = cinfo.output_width;
+    height = cinfo.output_height;
+    channels = cinfo.output_components;
+
+    int row_stride = width * channels;
+    image_data.resize(height * row_stride);
+
+    while (cinfo.output_scanline < cinfo.output_height) {
+        unsigned char* row_pointer = &image_data[cinfo.output_scanline * row_stride];
+        jpeg_read_scanlines(&cinfo, &row_pointer, 1);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+}
+
+bool JPEGProcessor::read_jpeg_header(const std::vector<unsigned char>& jpeg_data, int& width, int& height, int& channels) {
+    struct jpeg_decompress_struct cinfo;
+    RecoverableError jerr;
+
+    if (jpeg_data.empty()) return false;
+
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = recoverable_error_exit;
+    if (setjmp(jerr.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, jpeg_data.data(), static_cast<unsigned long>(jpeg_data.size()));
+    jpeg_read_header(&cinfo, TRUE);
+
+    width = cinfo.image_width;
+    height = cinfo.image_height;
+    channels = cinfo.num_components;
+    const bool supported = decodes_to_rgb(cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return supported;
+}
+
+int JPEGProcessor::max_dimension() {
+    return JPEG_MAX_DIMENSION;
+}
+
+void JPEGProcessor::write_jpeg_file(const std::string& filename, const std::vector<unsigned char>& image_data, int width, int height, int channels, int quality) {
+    struct jpeg_compress_struct cinfo;
+    RecoverableError jerr;
+    std::vector<unsigned char> packed = packing_buffer(width, channels);
+
+    FILE* outfile = open_output(filename);
+
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = recoverable_error_exit;
+    if (setjmp(jerr.jump)) {
+        jpeg_destroy_compress(&cinfo);
+        fclose(outfile);
+        throw std::runtime_error(std::string("JPEG encode failed: ") + jerr.message);
+    }
     jpeg_create_compress(&cinfo);
     jpeg_stdio_dest(&cinfo, outfile);
 
-    cinfo.image_width = width;
-    cinfo.image_height = height;
-    cinfo.input_components = channels;
-    cinfo.in_color_space = (channels == 3) ? JCS_RGB : JCS_GRAYSCALE;
-
-    jpeg_set_defaults(&cinfo);
-    jpeg_set_quality(&cinfo, quality, TRUE);
+    configure_compress(cinfo, width, height, channels, quality);
 
     jpeg_start_compress(&cinfo, TRUE);
+    write_scanlines(cinfo, image_data.data(), width, channels, packed);
 
-    int row_stride = width * channels;
-    while (cinfo.next_scanline < cinfo.image_height) {
-        const unsigned char* row_pointer = &image_data[cinfo.next_scanline * row_stride];
-        jpeg_write_scanlines(&cinfo, const_cast<JSAMPARRAY>(&row_pointer), 1);
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    fclose(outfile);
+}
+
+void JPEGProcessor::write_jpeg_file_rows(const std::string& filename, int width, int height, int channels, int quality,
+                                         int band_rows, const std::function<void(int, int, unsigned char*)>& fill) {
+    struct jpeg_compress_struct cinfo;
+    RecoverableError jerr;
+    band_rows = std::max(band_rows, 1);
+    std::vector<unsigned char> band(static_cast<size_t>(width) * channels * band_rows);
+    std::vector<unsigned char> packed = packing_buffer(width, channels);
+    std::exception_ptr fill_failure;
+
+    FILE* outfile = open_output(filename);
+
+    // The file is truncated by now, so a failed encode removes it rather than leave a torn JPEG.
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = recoverable_error_exit;
+    if (setjmp(jerr.jump)) {
+        jpeg_destroy_compress(&cinfo);
+        fclose(outfile);
+        std::remove(filename.c_str());
+        throw std::runtime_error(std::string("JPEG encode failed: ") + jerr.message);
+    }
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, outfile);
+
+    configure_compress(cinfo, width, height, channels, quality);
+
+    jpeg_start_compress(&cinfo, TRUE);
+    for (int first_row = 0; first_row < height; first_row += band_rows) {
+        int rows = std::min(band_rows, height - first_row);
+        try {
+            fill(first_row, rows, band.data());
+        }
+        catch (...) {
+            fill_failure = std::current_exception();
+            break;
+        }
+        write_scanlines(cinfo, band.data(), width, channels, packed, first_row, first_row + rows);
     }
 
+    if (fill_failure) {
+        jpeg_destroy_compress(&cinfo);
+        fclose(outfile);
+        std::remove(filename.c_str());
+        std::rethrow_exception(fill_failure);
+    }
     jpeg_finish_compress(&cinfo);
     jpeg_destroy_compress(&cinfo);
-    fclose(outfile);
+    if (fclose(outfile) != 0) {
+        std::remove(filename.c_str());
+        throw std::runtime_error("Error writing output file: " + filename);
+    }
+}
+
+void JPEGProcessor::write_jpeg_file_parallel(const std::string& filename, const std::vector<unsigned char>& image_data, int width, int height, int channels, int quality, int strips) {
+    int mcu_height = mcu_row_height(channels, quality);
+    int mcu_rows = (height + mcu_height - 1) / mcu_height;
+
+    if (strips <= 0) strips = omp_get_max_threads();
+    strips = std::min(strips, mcu_rows);
+
+    if (strips <= 1) {
+        write_jpeg_file(filename, image_data, width, height, channels, quality);
+        return;
+    }
+
+    int strip_height = ((mcu_rows + strips - 1) / strips) * mcu_height;
+    strips = (height + strip_height - 1) / strip_height;
+
+    std::vector<std::vector<unsigned char>> encoded(strips);
+    int row_stride = width * channels;
+    std::exception_ptr failure;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int i = 0; i < strips; ++i) {
+        int first_row = i * strip_height;
+        int rows = std::min(strip_height, height - first_row);
+        try {
+            encoded[i] = encode_strip(&image_data[static_cast<size_t>(first_row) * row_stride], width, rows, channels, quality);
+        }
+        catch (...) {
+            #pragma omp critical(jpeg_strip_failure)
+            if (!failure) failure = std::current_exception();
+        }
+    }
+    if (failure) std::rethrow_exception(failure);
+
+    std::vector<unsigned char> output = stitch_strips(encoded, height);
+
+    FILE* outfile = open_output(filename);
+    size_t written = fwrite(output.data(), 1, output.size(), outfile);
+    if (fclose(outfile) != 0 || written != output.size()) {
+        throw std::runtime_error("Error writing output file: " + filename);
+    }
+}
+
+JPEGStripCache::JPEGStripCache(int width, int height, int channels, int quality, int strip_rows)
+    : width(width), height(height), channels(channels), quality(quality) {
+    int mcu_height = mcu_row_height(channels, quality);
+    strip_height = ((std::max(strip_rows, 1) + mcu_height - 1) / mcu_height) * mcu_height;
+    strips.resize((height + strip_height - 1) / strip_height);
+}
+
+std::vector<unsigned char> JPEGStripCache::encode(const std::vector<unsigned char>& image_data, const std::vector<std::pair<int, int>>& dirty_rows) {
+    const int count = static_cast<int>(strips.size());
+    std::vector<char> dirty(count, 0);
+    for (int i = 0; i < count; ++i) {
+        if (strips[i].empty()) dirty[i] = 1;
+    }
+    for (const auto& rows : dirty_rows) {
+        if (rows.second <= rows.first) continue;
+        int first = std::max(rows.first, 0) / strip_height;
+        int last = std::min((std::min(rows.second, height) - 1) / strip_height, count - 1);
+        for (int i = first; i <= last; ++i) dirty[i] = 1;
+    }
+
+    std::vector<int> work;
+    for (int i = 0; i < count; ++i) {
+        if (dirty[i]) work.push_back(i);
+    }
+    last_encoded = static_cast<int>(work.size());
+
+    const size_t row_stride = static_cast<size_t>(width) * channels;
+    std::exception_ptr failure;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int w = 0; w < static_cast<int>(work.size()); ++w) {
+        int i = work[w];
+        int first_row = i * strip_height;
+        int rows = std::min(strip_height, height - first_row);
+        try {
+            strips[i] = encode_strip(&image_data[static_cast<size_t>(first_row) * row_stride], width, rows, channels, quality);
+        }
+        catch (...) {
+            #pragma omp critical(jpeg_strip_failure)
+            if (!failure) failure = std::current_exception();
+            strips[i].clear();
+        }
+    }
+    if (failure) std::rethrow_exception(failure);
+
+    return stitch_strips(strips, height);
 }
\ No newline at end of file
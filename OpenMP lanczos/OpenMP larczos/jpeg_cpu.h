@@ -1,9 +1,50 @@
 #pragma once
+#include <functional>
 #include <vector>
 #include <string>
+#include <utility>
 
 class JPEGProcessor {
 public:
+    // The readers produce 1 (grey) or 3 (RGB) channels; CMYK/YCCK files are rejected
+    // (image_data left empty) rather than passed on as four channels.
     static void read_jpeg_file(const std::string& filename, std::vector<unsigned char>& image_data, int& width, int& height, int& channels);
+    // scale_denom 2, 4 or 8 decodes straight to 1/n size (rounded up) in the DCT domain.
+    static void read_jpeg_memory(const std::vector<unsigned char>& jpeg_data, std::vector<unsigned char>& image_data, int& width, int& height, int& channels, int scale_denom = 1);
+    // Image size and component count from the header alone; false if it cannot be parsed
+    // or is CMYK/YCCK.
+    static bool read_jpeg_header(const std::vector<unsigned char>& jpeg_data, int& width, int& height, int& channels);
+    // Largest width or height libjpeg can encode (JPEG_MAX_DIMENSION).
+    static int max_dimension();
+    // The writers throw std::runtime_error when the file cannot be opened or libjpeg fails.
     static void write_jpeg_file(const std::string& filename, const std::vector<unsigned char>& image_data, int width, int height, int channels, int quality);
+
+    // Encodes an image supplied `band_rows` rows at a time by fill(first_row, rows, band),
+    // so only one band is ever resident; for outputs too large to hold in memory.
+    static void write_jpeg_file_rows(const std::string& filename, int width, int height, int channels, int quality,
+                                     int band_rows, const std::function<void(int, int, unsigned char*)>& fill);
+
+    // Encodes horizontal MCU-aligned strips on separate threads and stitches them into
+    // one baseline JPEG using restart markers. strips <= 0 uses one strip per OpenMP thread.
+    static void write_jpeg_file_parallel(const std::string& filename, const std::vector<unsigned char>& image_data, int width, int height, int channels, int quality, int strips = 0);
+};
+
+// Keeps the encoded MCU-row strips of the previous frame, so a frame that changed only in
+// some rows re-encodes just the strips covering them; the rest are re-stitched as is.
+class JPEGStripCache {
+public:
+    JPEGStripCache(int width, int height, int channels, int quality, int strip_rows = 64);
+
+    // dirty_rows are [begin, end) row ranges changed since the previous call; strips never
+    // encoded (all of them on the first call) are always encoded.
+    std::vector<unsigned char> encode(const std::vector<unsigned char>& image_data, const std::vector<std::pair<int, int>>& dirty_rows);
+
+    int last_encoded_strips() const { return last_encoded; }
+    int strip_count() const { return static_cast<int>(strips.size()); }
+
+private:
+    int width, height, channels, quality;
+    int strip_height;
+    int last_encoded = 0;
+    std::vector<std::vector<unsigned char>> strips;
 };
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Symmetric filter kernel sampled `resolution` times per unit on [0, support] and
+// linearly interpolated between samples. Replaces per-tap sin() calls in resamplers
+// that cannot precompute weights per axis (e.g. affine warps).
+template <typename T>
+class KernelLUT {
+public:
+    template <typename Kernel>
+    KernelLUT(Kernel kernel, T support, int resolution)
+        : support(support), resolution(static_cast<T>(std::max(resolution, 1))) {
+        int samples = static_cast<int>(std::ceil(support * this->resolution));
+        table.resize(samples + 2, T(0)); // trailing zero so interpolation never reads past the end
+        for (int i = 0; i <= samples; ++i) {
+            table[i] = static_cast<T>(kernel(std::min(i / this->resolution, support)));
+        }
+        table[samples] = T(0);
+    }
+
+    T operator()(T x) const {
+        x = std::abs(x);
+        if (x >= support) return T(0);
+        T position = x * resolution;
+        int i = static_cast<int>(position);
+        T fraction = position - i;
+        return table[i] + fraction * (table[i + 1] - table[i]);
+    }
+
+    T radius() const { return support; }
+
+private:
+    std::vector<T> table;
+    T support;
+    T resolution;
+};
\ No newline at end of file
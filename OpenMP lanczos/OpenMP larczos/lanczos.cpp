@@ -1,62 +1,286 @@
 #include "lanczos.h"
+#include "separable.h"
+#include "adaptive.h"
+#include "tiled_raw.h"
 #include <cmath>
 #include <algorithm>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <omp.h>
 //lanczos v1 cpu (OpenMP)
 
 #define M_PI 3.14159265358979323846
 
 namespace {
-    double sinc(double x) {
-        if (x == 0) return 1.0;
-        return std::sin(M_PI * x) / (M_PI * x);
+    template <typename T>
+    T sinc(T x) {
+        if (x == 0) return T(1);
+        return std::sin(T(M_PI) * x) / (T(M_PI) * x);
     }
 
-    double lanczos(double x, int a) {
-        if (x == 0) return 1.0;
+    template <typename T>
+    T lanczos(T x, int a) {
+        if (x == 0) return T(1);
         if (x > -a && x < a) return sinc(x) * sinc(x / a);
-        return 0.0;
+        return T(0);
+    }
+
+    template <typename T>
+    Separable::Axis<T> build_lanczos_axis(int input_size, int output_size, int a, EdgeMode edge) {
+        T ratio = static_cast<T>(input_size) / output_size;
+        return Separable::build_axis<T>(input_size, output_size, 2 * a, edge,
+            [ratio](int i) { return (i + T(0.5)) * ratio - T(0.5); },
+            [a](T center) { return static_cast<int>(center) - a + 1; },
+            [a](T distance) { return lanczos(distance, a); });
+    }
+
+    template <typename T>
+    std::pair<Separable::Axis<T>, Separable::Axis<T>> build_axes(int input_width, int input_height,
+                                                                 int output_width, int output_height,
+                                                                 int a, EdgeMode edge) {
+        return { build_lanczos_axis<T>(input_width, output_width, a, edge),
+                 build_lanczos_axis<T>(input_height, output_height, a, edge) };
+    }
+
+    template <typename T>
+    std::vector<unsigned char> upscale_impl(const unsigned char* input, size_t row_stride,
+                                            int input_width, int input_height, int channels,
+                                            int output_width, int output_height,
+                                            int a, EdgeMode edge, AlphaMode alpha) {
+        auto [x_axis, y_axis] = build_axes<T>(input_width, input_height, output_width, output_height, a, edge);
+        return Separable::resample(input, row_stride, channels, x_axis, y_axis, alpha);
+    }
+
+    template <typename T>
+    std::vector<unsigned char> upscale_adaptive_impl(const std::vector<unsigned char>& input,
+                                                     int input_width, int input_height, int channels,
+                                                     int output_width, int output_height,
+                                                     int a, int threshold, EdgeMode edge, AlphaMode alpha,
+                                                     Adaptive::Stats* stats) {
+        auto [x_full, y_full] = build_axes<T>(input_width, input_height, output_width, output_height, a, edge);
+        auto [x_cheap, y_cheap] = build_axes<T>(input_width, input_height, output_width, output_height, 2, edge);
+        return Adaptive::resample(input, input_width, input_height, channels, x_full, y_full, x_cheap, y_cheap,
+                                  alpha, threshold, stats);
+    }
+
+    template <typename T>
+    void upscale_tiles_impl(const std::vector<unsigned char>& input,
+                            int input_width, int input_height, int channels,
+                            std::vector<unsigned char>& output, int output_width, int output_height,
+                            const std::function<void(const Tiles::Tile&)>& on_tile,
+                            int a, EdgeMode edge, AlphaMode alpha) {
+        auto [x_axis, y_axis] = build_axes<T>(input_width, input_height, output_width, output_height, a, edge);
+        const size_t row_stride = static_cast<size_t>(input_width) * channels;
+        unsigned char* data = output.data();
+        auto destination = [=](const Tiles::Tile& tile, int y) {
+            return data + (static_cast<size_t>(y) * output_width + tile.x0) * channels;
+        };
+
+        Separable::dispatch_channels(channels, alpha, [&](auto c, auto premultiply) {
+            Tiles::parallel_for(output_width, output_height, Tiles::current_size(), [&](const Tiles::Tile& tile) {
+                Separable::resample_tile<T, decltype(c)::value, decltype(premultiply)::value>(
+                    input.data(), row_stride, x_axis, y_axis, tile, destination);
+                on_tile(tile);
+            });
+        });
+    }
+
+    template <typename T>
+    void upscale_tiled_impl(const std::vector<unsigned char>& input,
+                            int input_width, int input_height, int channels,
+                            TiledRaw& output, int a, EdgeMode edge, AlphaMode alpha) {
+        auto [x_axis, y_axis] = build_axes<T>(input_width, input_height, output.width(), output.height(), a, edge);
+        Separable::resample_into(input.data(), static_cast<size_t>(input_width) * channels, channels,
+            x_axis, y_axis, alpha, output.tile_size(),
+            [&output](const Tiles::Tile& tile, int y) { return output.row(tile, y); });
     }
 }
 
 namespace Lanczos {
+    double kernel(double x, int a) {
+        return lanczos(x, a);
+    }
+
     std::vector<unsigned char> upscale(const std::vector<unsigned char>& input,
                                        int input_width, int input_height, int channels,
                                        int output_width, int output_height,
-                                       int a) {
-        std::vector<unsigned char> output(output_width * output_height * channels);
-        double x_ratio = static_cast<double>(input_width) / output_width;
-        double y_ratio = static_cast<double>(input_height) / output_height;
-
-        #pragma omp parallel for collapse(2)
-        for (int y = 0; y < output_height; ++y) {
-            for (int x = 0; x < output_width; ++x) {
-                double x_l = (x + 0.5) * x_ratio - 0.5;
-                double y_l = (y + 0.5) * y_ratio - 0.5;
-                int x_i = static_cast<int>(x_l);
-                int y_i = static_cast<int>(y_l);
-
-                for (int c = 0; c < channels; ++c) {
-                    double result = 0.0;
-                    double normalizer = 0.0;
-
-                    for (int m = -a + 1; m <= a; ++m) {
-                        for (int n = -a + 1; n <= a; ++n) {
-                            int cur_x = std::clamp(x_i + m, 0, input_width - 1);
-                            int cur_y = std::clamp(y_i + n, 0, input_height - 1);
-                            double weight = lanczos(x_l - cur_x, a) * lanczos(y_l - cur_y, a);
-
-                            result += weight * input[(cur_y * input_width + cur_x) * channels + c];
-                            normalizer += weight;
-                        }
-                    }
+                                       int a, Precision precision, EdgeMode edge, AlphaMode alpha) {
+        return upscale(input.data(), static_cast<size_t>(input_width) * channels, input_width, input_height, channels,
+                       output_width, output_height, a, precision, edge, alpha);
+    }
+
+    std::vector<unsigned char> upscale(const unsigned char* input, size_t row_stride,
+                                       int input_width, int input_height, int channels,
+                                       int output_width, int output_height,
+                                       int a, Precision precision, EdgeMode edge, AlphaMode alpha) {
+        if (precision == Precision::Float) {
+            return upscale_impl<float>(input, row_stride, input_width, input_height, channels, output_width, output_height, a, edge, alpha);
+        }
+        return upscale_impl<double>(input, row_stride, input_width, input_height, channels, output_width, output_height, a, edge, alpha);
+    }
 
-                    output[(y * output_width + x) * channels + c] = 
-                        static_cast<unsigned char>(std::clamp(result / normalizer, 0.0, 255.0));
+    void upscale_tiled(const std::vector<unsigned char>& input,
+                       int input_width, int input_height, int channels,
+                       TiledRaw& output, int a, Precision precision, EdgeMode edge, AlphaMode alpha) {
+        if (output.read_only()) throw std::invalid_argument("Tiled output is read-only");
+        if (output.channels() != channels) throw std::invalid_argument("Tiled output channel count does not match input");
+        if (precision == Precision::Float) {
+            upscale_tiled_impl<float>(input, input_width, input_height, channels, output, a, edge, alpha);
+        }
+        else {
+            upscale_tiled_impl<double>(input, input_width, input_height, channels, output, a, edge, alpha);
+        }
+    }
+
+    std::vector<unsigned char> upscale_adaptive(const std::vector<unsigned char>& input,
+                                                int input_width, int input_height, int channels,
+                                                int output_width, int output_height,
+                                                int a, int threshold, Precision precision, EdgeMode edge, AlphaMode alpha,
+                                                Adaptive::Stats* stats) {
+        if (precision == Precision::Float) {
+            return upscale_adaptive_impl<float>(input, input_width, input_height, channels, output_width, output_height, a, threshold, edge, alpha, stats);
+        }
+        return upscale_adaptive_impl<double>(input, input_width, input_height, channels, output_width, output_height, a, threshold, edge, alpha, stats);
+    }
+
+    void upscale_tiles(const std::vector<unsigned char>& input,
+                       int input_width, int input_height, int channels,
+                       std::vector<unsigned char>& output, int output_width, int output_height,
+                       const std::function<void(const Tiles::Tile&)>& on_tile,
+                       int a, Precision precision, EdgeMode edge, AlphaMode alpha) {
+        output.resize(static_cast<size_t>(output_width) * output_height * channels);
+        if (precision == Precision::Float) {
+            upscale_tiles_impl<float>(input, input_width, input_height, channels, output, output_width, output_height, on_tile, a, edge, alpha);
+        }
+        else {
+            upscale_tiles_impl<double>(input, input_width, input_height, channels, output, output_width, output_height, on_tile, a, edge, alpha);
+        }
+    }
+
+    struct AxisCache::Impl {
+        // (input size, output size, a, edge) -> axis
+        using Key = std::tuple<int, int, int, int>;
+        std::map<Key, std::shared_ptr<const Separable::Axis<float>>> float_axes;
+        std::map<Key, std::shared_ptr<const Separable::Axis<double>>> double_axes;
+
+        template <typename T>
+        std::shared_ptr<const Separable::Axis<T>> get(int input_size, int output_size, int a, EdgeMode edge) {
+            auto& axes = [this]() -> auto& {
+                if constexpr (std::is_same_v<T, float>) return float_axes;
+                else return double_axes;
+            }();
+            auto& axis = axes[Key(input_size, output_size, a, static_cast<int>(edge))];
+            if (!axis) axis = std::make_shared<const Separable::Axis<T>>(build_lanczos_axis<T>(input_size, output_size, a, edge));
+            return axis;
+        }
+    };
+
+    AxisCache::AxisCache() : impl(std::make_unique<Impl>()) {}
+    AxisCache::~AxisCache() = default;
+
+    struct Plan::Impl {
+        int input_width, input_height, output_width, output_height;
+        Precision precision;
+        std::pair<std::shared_ptr<const Separable::Axis<float>>, std::shared_ptr<const Separable::Axis<float>>> float_axes;
+        std::pair<std::shared_ptr<const Separable::Axis<double>>, std::shared_ptr<const Separable::Axis<double>>> double_axes;
+
+        template <typename T>
+        std::pair<const Separable::Axis<T>&, const Separable::Axis<T>&> axes() const {
+            if constexpr (std::is_same_v<T, float>) return { *float_axes.first, *float_axes.second };
+            else return { *double_axes.first, *double_axes.second };
+        }
+
+        template <typename T>
+        void build(int a, EdgeMode edge, AxisCache* cache) {
+            std::shared_ptr<const Separable::Axis<T>> x_axis, y_axis;
+            if (cache) {
+                x_axis = cache->impl->get<T>(input_width, output_width, a, edge);
+                y_axis = cache->impl->get<T>(input_height, output_height, a, edge);
+            }
+            else {
+                x_axis = std::make_shared<const Separable::Axis<T>>(build_lanczos_axis<T>(input_width, output_width, a, edge));
+                y_axis = std::make_shared<const Separable::Axis<T>>(build_lanczos_axis<T>(input_height, output_height, a, edge));
+            }
+            if constexpr (std::is_same_v<T, float>) float_axes = { x_axis, y_axis };
+            else double_axes = { x_axis, y_axis };
+        }
+
+        // Outputs of one axis whose taps read any source index in [begin, end).
+        template <typename T>
+        static void affected_range(const Separable::Axis<T>& axis, int begin, int end, int& lo, int& hi) {
+            const int outputs = static_cast<int>(axis.first.size());
+            lo = outputs;
+            hi = 0;
+            for (int i = 0; i < outputs; ++i) {
+                const int* index = &axis.index[static_cast<size_t>(i) * axis.taps];
+                for (int k = 0; k < axis.taps; ++k) {
+                    if (index[k] >= begin && index[k] < end) {
+                        lo = std::min(lo, i);
+                        hi = i + 1;
+                        break;
+                    }
                 }
             }
         }
 
-        return output;
+        template <typename T>
+        Tiles::Tile affected(const Tiles::Tile& changed) const {
+            Tiles::Tile region;
+            affected_range(axes<T>().first, changed.x0, changed.x1, region.x0, region.x1);
+            affected_range(axes<T>().second, changed.y0, changed.y1, region.y0, region.y1);
+            if (region.x0 >= region.x1 || region.y0 >= region.y1) region = { 0, 0, 0, 0 };
+            return region;
+        }
+
+        template <typename T>
+        void run(const std::vector<unsigned char>& input, int channels, std::vector<unsigned char>& output,
+                 const Tiles::Tile& region, AlphaMode alpha) const {
+            const auto& [x_axis, y_axis] = axes<T>();
+            const size_t row_stride = static_cast<size_t>(input_width) * channels;
+            unsigned char* data = output.data();
+            const int width = output_width;
+            auto destination = [=](const Tiles::Tile& tile, int y) {
+                return data + (static_cast<size_t>(y) * width + tile.x0) * channels;
+            };
+
+            Separable::dispatch_channels(channels, alpha, [&](auto c, auto premultiply) {
+                Tiles::parallel_for(region.x1 - region.x0, region.y1 - region.y0, Tiles::current_size(), [&](Tiles::Tile tile) {
+                    tile.x0 += region.x0; tile.x1 += region.x0;
+                    tile.y0 += region.y0; tile.y1 += region.y0;
+                    Separable::resample_tile<T, decltype(c)::value, decltype(premultiply)::value>(
+                        input.data(), row_stride, x_axis, y_axis, tile, destination);
+                });
+            });
+        }
+    };
+
+    Plan::Plan(int input_width, int input_height, int output_width, int output_height,
+               int a, Precision precision, EdgeMode edge, AxisCache* cache)
+        : impl(std::make_unique<Impl>()) {
+        impl->input_width = input_width;
+        impl->input_height = input_height;
+        impl->output_width = output_width;
+        impl->output_height = output_height;
+        impl->precision = precision;
+        if (precision == Precision::Float) impl->build<float>(a, edge, cache);
+        else impl->build<double>(a, edge, cache);
+    }
+
+    Plan::~Plan() = default;
+
+    Tiles::Tile Plan::affected(const Tiles::Tile& changed) const {
+        if (impl->precision == Precision::Float) return impl->affected<float>(changed);
+        return impl->affected<double>(changed);
+    }
+
+    void Plan::run(const std::vector<unsigned char>& input, int channels,
+                   std::vector<unsigned char>& output, const Tiles::Tile& region, AlphaMode alpha) const {
+        if (region.x0 >= region.x1 || region.y0 >= region.y1) return;
+        if (impl->precision == Precision::Float) impl->run<float>(input, channels, output, region, alpha);
+        else impl->run<double>(input, channels, output, region, alpha);
     }
 }
\ No newline at end of file
@@ -1,9 +1,99 @@
 #pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <vector>
+#include "precision.h"
+#include "edge_mode.h"
+#include "pixel_format.h"
+#include "tiles.h"
+
+class TiledRaw;
+namespace Adaptive { struct Stats; }
 
 namespace Lanczos {
+    // Windowed sinc L(x) = sinc(x) sinc(x / a) for |x| < a, 0 elsewhere.
+    double kernel(double x, int a);
+
     std::vector<unsigned char> upscale(const std::vector<unsigned char>& input,
                                        int input_width, int input_height, int channels,
                                        int output_width, int output_height,
-                                       int a = 3);
+                                       int a = 3, Precision precision = Precision::Double,
+                                       EdgeMode edge = EdgeMode::Clamp,
+                                       AlphaMode alpha = AlphaMode::Premultiply);
+
+    // Same, reading a borrowed buffer in place; rows start row_stride bytes apart.
+    std::vector<unsigned char> upscale(const unsigned char* input, size_t row_stride,
+                                       int input_width, int input_height, int channels,
+                                       int output_width, int output_height,
+                                       int a = 3, Precision precision = Precision::Double,
+                                       EdgeMode edge = EdgeMode::Clamp,
+                                       AlphaMode alpha = AlphaMode::Premultiply);
+
+    // Same resample written tile by tile into a mapped container; the output size is the
+    // container's.
+    void upscale_tiled(const std::vector<unsigned char>& input,
+                       int input_width, int input_height, int channels,
+                       TiledRaw& output, int a = 3, Precision precision = Precision::Double,
+                       EdgeMode edge = EdgeMode::Clamp,
+                       AlphaMode alpha = AlphaMode::Premultiply);
+
+    // Per-tile choice between Lanczos2 and the full kernel (see adaptive.h): tiles whose
+    // source footprint has no gradient >= threshold use the cheap kernel.
+    std::vector<unsigned char> upscale_adaptive(const std::vector<unsigned char>& input,
+                                                int input_width, int input_height, int channels,
+                                                int output_width, int output_height,
+                                                int a, int threshold, Precision precision = Precision::Double,
+                                                EdgeMode edge = EdgeMode::Clamp,
+                                                AlphaMode alpha = AlphaMode::Premultiply,
+                                                Adaptive::Stats* stats = nullptr);
+
+    // Resamples into an existing output buffer (output_width * output_height * channels),
+    // calling on_tile after each tile is written, from the thread that wrote it. Honours
+    // Tiles::current_cancel().
+    void upscale_tiles(const std::vector<unsigned char>& input,
+                       int input_width, int input_height, int channels,
+                       std::vector<unsigned char>& output, int output_width, int output_height,
+                       const std::function<void(const Tiles::Tile&)>& on_tile,
+                       int a = 3, Precision precision = Precision::Double,
+                       EdgeMode edge = EdgeMode::Clamp,
+                       AlphaMode alpha = AlphaMode::Premultiply);
+
+    // Axis tap tables shared between the plans of one input, so outputs of equal width (or
+    // height) build that axis once (see multi_target.h). Not thread-safe.
+    class AxisCache {
+    public:
+        AxisCache();
+        ~AxisCache();
+        AxisCache(const AxisCache&) = delete;
+        AxisCache& operator=(const AxisCache&) = delete;
+
+    private:
+        friend class Plan;
+        struct Impl;
+        std::unique_ptr<Impl> impl;
+    };
+
+    // Tap tables for one fixed geometry, kept so that frame sequences can recompute only
+    // parts of the output (see incremental.h).
+    class Plan {
+    public:
+        Plan(int input_width, int input_height, int output_width, int output_height,
+             int a = 3, Precision precision = Precision::Double, EdgeMode edge = EdgeMode::Clamp,
+             AxisCache* cache = nullptr);
+        ~Plan();
+
+        // Smallest output rectangle containing every pixel that reads from the source
+        // rectangle `changed` (edge mapping included); empty when none does.
+        Tiles::Tile affected(const Tiles::Tile& changed) const;
+
+        // Resamples just `region` of the output into `output` (already output-sized).
+        void run(const std::vector<unsigned char>& input, int channels,
+                 std::vector<unsigned char>& output, const Tiles::Tile& region,
+                 AlphaMode alpha = AlphaMode::Premultiply) const;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl;
+    };
 }
\ No newline at end of file
@@ -5,15 +5,311 @@
 #include <stdexcept>
 #include <filesystem> // Requires C++17
 #include <algorithm>
-#include "lanczos.h"
+#include "daemon.h"
+#include "pipeline.h"
+#include "result_cache.h"
+#include "benchmark.h"
+#include "affine.h"
+#include "tuning.h"
+#include "multi_target.h"
+#include "batch.h"
+#include "tiled_raw.h"
+#include "shard.h"
+#include "progressive.h"
+#include "incremental.h"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
 
 // Namespace alias for filesystem
 namespace fs = std::filesystem;
 
 int main(int argc, char* argv[]) {
+    // Daemon mode: keep a warm worker pool behind a Unix domain socket
+    if (argc >= 3 && std::string(argv[1]) == "--serve") {
+        ResizeDaemon::Options options;
+        options.socket_path = argv[2];
+        try {
+            if (argc >= 4) options.workers = std::stoi(argv[3]);
+            if (argc >= 5) options.queue_capacity = std::stoul(argv[4]);
+            if (argc >= 6) options.memory_budget = static_cast<size_t>(std::stoul(argv[5])) << 20;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Invalid daemon options: " << e.what() << "\n";
+            return 1;
+        }
+        return ResizeDaemon::serve(options);
+    }
+
+    // Benchmark mode: time each filter at float and double precision
+    if (argc >= 4 && std::string(argv[1]) == "--benchmark") {
+        try {
+            int runs = (argc >= 5) ? std::stoi(argv[4]) : 3;
+            return Benchmark::run(argv[2], std::stof(argv[3]), runs);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Benchmark failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // Profile mode: per-stage wall time and hardware counters for one image
+    if (argc == 5 && std::string(argv[1]) == "--profile") {
+        try {
+            return Benchmark::profile(argv[2], argv[3], std::stof(argv[4]));
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Profile failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // Autotune mode: measure thread count, tile size and layout on this host
+    if (argc >= 5 && std::string(argv[1]) == "--autotune") {
+        try {
+            std::vector<std::string> images(argv + 4, argv + argc);
+            return Tuning::autotune(argv[2], std::stof(argv[3]), images);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Autotune failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // Multi-target mode: one decode fanned out to several widths (<prefix>_<w>x<h>.jpg)
+    if (argc == 5 && std::string(argv[1]) == "--widths") {
+        std::vector<unsigned char> image_data;
+        int width = 0, height = 0, channels = 0;
+        JPEGProcessor::read_jpeg_file(argv[2], image_data, width, height, channels);
+        if (image_data.empty()) return 1;
+
+        try {
+            std::vector<int> widths;
+            std::stringstream list(argv[4]);
+            std::string item;
+            while (std::getline(list, item, ',')) widths.push_back(std::stoi(item));
+
+            auto targets = MultiTarget::from_widths(widths, width, height, argv[3]);
+            for (const auto& result : MultiTarget::run(image_data, width, height, channels, targets, Pipeline::Params())) {
+                std::cout << "Written " << result.output_path << " (resample " << result.resample_ms << " ms)\n";
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error during multi-target resize: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Batch mode: resample a directory of JPEGs, reading the next files ahead
+    if ((argc >= 5 && argc <= 7) && std::string(argv[1]) == "--batch") {
+        try {
+            Pipeline::Params params;
+            params.scale = std::stof(argv[4]);
+            if (params.scale <= 0.0f) throw std::invalid_argument("scale factor must be positive");
+
+            Prefetcher::Options prefetch;
+            if (argc >= 6) prefetch.depth = std::max(1, std::stoi(argv[5]));
+            if (argc >= 7) prefetch.memory_budget = static_cast<size_t>(std::stoul(argv[6])) << 20;
+            return Batch::run(argv[2], argv[3], params, prefetch) == 0 ? 0 : 1;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Batch failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // Sharded batch: a coordinator process and worker processes over shared memory
+    if ((argc == 5 || argc == 6) && std::string(argv[1]) == "--shard-coordinator") {
+        try {
+            ShardedBatch::Options options;
+            options.input_dir = argv[2];
+            options.output_dir = argv[3];
+            options.params.scale = std::stof(argv[4]);
+            if (options.params.scale <= 0.0f) throw std::invalid_argument("scale factor must be positive");
+            if (argc == 6) options.workers = std::stoi(argv[5]);
+            return ShardedBatch::coordinate(options) == 0 ? 0 : 1;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Sharded batch failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    if (argc == 3 && std::string(argv[1]) == "--shard-worker") {
+        try {
+            return ShardedBatch::work(argv[2]);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Worker failed: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // Progressive mode: preview first (written as <output>.preview.jpg), then refine
+    if (argc == 5 && std::string(argv[1]) == "--progressive") {
+        try {
+            using Clock = std::chrono::steady_clock;
+            auto ms = [](Clock::time_point since) { return std::chrono::duration<double, std::milli>(Clock::now() - since).count(); };
+
+            Pipeline::Params params;
+            params.scale = std::stof(argv[4]);
+            std::vector<unsigned char> jpeg_bytes = Pipeline::read_file_bytes(argv[2]);
+            std::string preview_path = std::string(argv[3]) + ".preview.jpg";
+
+            auto start = Clock::now();
+            double preview_ms = 0.0, first_tile_ms = 0.0;
+            int tiles = 0;
+            Progressive::Callbacks callbacks;
+            callbacks.preview = [&](const std::vector<unsigned char>& image, int w, int h, int c) {
+                preview_ms = ms(start);
+                JPEGProcessor::write_jpeg_file(preview_path, image, w, h, c, 80);
+            };
+            callbacks.tile = [&](const Tiles::Tile&, const std::vector<unsigned char>&) {
+                if (tiles++ == 0) first_tile_ms = ms(start);
+            };
+
+            std::vector<unsigned char> image;
+            int width, height, channels;
+            Progressive::run(jpeg_bytes, params, callbacks, image, width, height, channels);
+            double total_ms = ms(start);
+            JPEGProcessor::write_jpeg_file_parallel(argv[3], image, width, height, channels, params.quality);
+
+            std::cout << "Preview after " << preview_ms << " ms (" << preview_path << "), first refined tile after "
+                      << first_tile_ms << " ms, " << tiles << " tiles refined after " << total_ms << " ms\n";
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error during progressive resize: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Frame-sequence mode: only regions that changed since the previous frame are recomputed
+    if (argc >= 5 && std::string(argv[1]) == "--frames") {
+        try {
+            Pipeline::Params params;
+            params.scale = std::stof(argv[3]);
+            std::unique_ptr<IncrementalResampler> resampler;
+            for (int i = 4; i < argc; ++i) {
+                int width, height, channels;
+                std::vector<unsigned char> frame;
+                JPEGProcessor::read_jpeg_file(argv[i], frame, width, height, channels);
+                if (frame.empty()) throw std::runtime_error(std::string("could not decode ") + argv[i]);
+                if (!resampler)
+                    resampler = std::make_unique<IncrementalResampler>(width, height, channels, params);
+
+                auto start = std::chrono::high_resolution_clock::now();
+                resampler->update(frame);
+                std::vector<unsigned char> jpeg = resampler->encode();
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+                std::string output_path = std::string(argv[2]) + "_" + std::to_string(i - 4) + ".jpg";
+                std::ofstream(output_path, std::ios::binary).write(reinterpret_cast<const char*>(jpeg.data()), jpeg.size());
+                const IncrementalResampler::Stats& stats = resampler->stats();
+                std::cout << output_path << ": " << (stats.full ? "full" : std::to_string(stats.regions) + " region(s)")
+                          << ", " << stats.recomputed * 100.0 << "% recomputed, " << elapsed.count() << " ms\n";
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error during frame resize: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Tiled mode: resample into a memory-mapped tiled raw container instead of a JPEG
+    if ((argc == 5 || argc == 6) && std::string(argv[1]) == "--tiled") {
+        std::vector<unsigned char> image_data;
+        int width = 0, height = 0, channels = 0;
+        JPEGProcessor::read_jpeg_file(argv[2], image_data, width, height, channels);
+        if (image_data.empty()) return 1;
+
+        try {
+            Pipeline::Params params;
+            params.scale = std::stof(argv[4]);
+            int new_width, new_height;
+            Pipeline::resolve_size(params, width, height, new_width, new_height);
+
+            Tiles::Size tile;
+            if (argc == 6) tile.width = tile.height = std::stoi(argv[5]);
+            TiledRaw output = TiledRaw::create(argv[3], new_width, new_height, channels, tile);
+            Pipeline::resample_tiled(image_data, width, height, channels, output, params);
+            output.flush();
+            std::cout << "Tiled output written to " << argv[3] << " (" << new_width << "x" << new_height << ", "
+                      << output.columns() << "x" << output.rows() << " tiles)\n";
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error writing tiled output: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Tile extraction: read one tile of a tiled container back out as a JPEG
+    if (argc == 6 && std::string(argv[1]) == "--extract-tile") {
+        try {
+            TiledRaw container = TiledRaw::open(argv[2]);
+            int column = std::stoi(argv[3]), row = std::stoi(argv[4]);
+            const Tiles::Size size = container.tile_size();
+            const int tile_width = std::min(size.width, container.width() - column * size.width);
+            const int tile_height = std::min(size.height, container.height() - row * size.height);
+            const int channels = container.channels();
+            const unsigned char* tile = container.tile(column, row);
+
+            // Tiles are stored padded to the full tile size; crop edge tiles.
+            std::vector<unsigned char> pixels(static_cast<size_t>(tile_width) * tile_height * channels);
+            for (int y = 0; y < tile_height; ++y) {
+                std::copy_n(tile + static_cast<size_t>(y) * size.width * channels, static_cast<size_t>(tile_width) * channels,
+                            pixels.begin() + static_cast<size_t>(y) * tile_width * channels);
+            }
+            JPEGProcessor::write_jpeg_file(argv[5], pixels, tile_width, tile_height, channels, 90);
+            std::cout << "Tile written to " << argv[5] << "\n";
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error reading tile: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Rotate mode: Lanczos affine warp about the image centre, canvas grown to fit
+    if (argc == 5 && std::string(argv[1]) == "--rotate") {
+        std::vector<unsigned char> image_data;
+        int width = 0, height = 0, channels = 0;
+        JPEGProcessor::read_jpeg_file(argv[2], image_data, width, height, channels);
+        if (image_data.empty()) return 1;
+
+        try {
+            int new_width, new_height;
+            Affine::Transform transform = Affine::rotation(std::stod(argv[4]), width, height, true, new_width, new_height);
+            std::vector<unsigned char> rotated = Affine::warp(image_data, width, height, channels, new_width, new_height, transform, 8);
+            JPEGProcessor::write_jpeg_file_parallel(argv[3], rotated, new_width, new_height, channels, 90);
+            std::cout << "Rotated image written to " << argv[3] << "\n";
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error during rotation: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
     // Ensure correct number of arguments
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> <scale_factor>\n";
+    if (argc != 4 && argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> <scale_factor> [float|double]\n"
+                  << "       " << argv[0] << " --serve <socket_path> [workers] [queue_capacity] [memory_mb]\n"
+                  << "       " << argv[0] << " --benchmark <input_image> <scale_factor> [runs]\n"
+                  << "       " << argv[0] << " --profile <input_image> <output_image> <scale_factor>\n"
+                  << "       " << argv[0] << " --rotate <input_image> <output_image> <degrees>\n"
+                  << "       " << argv[0] << " --autotune <profile_path> <scale_factor> <image>...\n"
+                  << "       " << argv[0] << " --widths <input_image> <output_prefix> <w1,w2,...>\n"
+                  << "       " << argv[0] << " --batch <input_dir> <output_dir> <scale_factor> [read_ahead] [budget_mb]\n"
+                  << "       " << argv[0] << " --shard-coordinator <input_dir> <output_dir> <scale_factor> [workers]\n"
+                  << "       " << argv[0] << " --shard-worker <segment_name>\n"
+                  << "       " << argv[0] << " --progressive <input_image> <output_image> <scale_factor>\n"
+                  << "       " << argv[0] << " --frames <output_prefix> <scale_factor> <frame>...\n"
+                  << "       " << argv[0] << " --tiled <input_image> <output.lzt> <scale_factor> [tile_size]\n"
+                  << "       " << argv[0] << " --extract-tile <input.lzt> <column> <row> <output_image>\n";
         return 1;
     }
 
@@ -35,6 +331,18 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    Pipeline::Params params;
+    params.scale = scale_factor;
+    if (argc == 5) {
+        try {
+            params.precision = parse_precision(argv[4]);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << ". Use float or double.\n";
+            return 1;
+        }
+    }
+
     // Check if the input image exists
     if (!fs::exists(input_image)) {
         std::cerr << "Input image does not exist: " << input_image << "\n";
@@ -49,13 +357,41 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Optional result cache (LANCZOS_CACHE_DIR): a hit costs one hash and one copy
+    std::unique_ptr<ResultCache> cache = ResultCache::from_environment();
+    std::vector<unsigned char> jpeg_bytes;
+    std::string cache_key;
+    if (cache) {
+        try {
+            jpeg_bytes = Pipeline::read_file_bytes(input_image.string());
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error reading input image: " << e.what() << "\n";
+            return 1;
+        }
+        cache_key = cache->key(jpeg_bytes, params);
+        if (cache->fetch(cache_key, output_image.string())) {
+            std::cout << "Upscaled image served from cache to " << output_image << "\n";
+            return 0;
+        }
+    }
+
     // Initialize variables for image data
     std::vector<unsigned char> image_data;
-    int width, height, channels;
+    int width = 0, height = 0, channels = 0;
 
     try {
         // Read the input JPEG file
-        JPEGProcessor::read_jpeg_file(input_image.string().c_str(), image_data, width, height, channels);
+        if (cache) {
+            JPEGProcessor::read_jpeg_memory(jpeg_bytes, image_data, width, height, channels);
+        }
+        else {
+            JPEGProcessor::read_jpeg_file(input_image.string().c_str(), image_data, width, height, channels);
+        }
+        if (image_data.empty()) {
+            std::cerr << "Error reading input image: could not decode " << input_image << "\n";
+            return 1;
+        }
         std::cout << "Image read: " << width << "x" << height << " with " << channels << " channels.\n";
     }
     catch (const std::exception& e) {
@@ -70,7 +406,7 @@ int main(int argc, char* argv[]) {
     std::vector<unsigned char> upscaled_image;
     try {
         // Perform the upscaling
-        upscaled_image = Lanczos::upscale(image_data, width, height, channels, new_width, new_height, 8);
+        upscaled_image = Pipeline::resample(image_data, width, height, channels, new_width, new_height, params);
     }
     catch (const std::exception& e) {
         std::cerr << "Error during upscaling: " << e.what() << "\n";
@@ -79,8 +415,9 @@ int main(int argc, char* argv[]) {
 
     try {
         // Write the upscaled image to the output file
-        JPEGProcessor::write_jpeg_file(output_image.string().c_str(), upscaled_image, new_width, new_height, channels, 90);
+        JPEGProcessor::write_jpeg_file_parallel(output_image.string().c_str(), upscaled_image, new_width, new_height, channels, 90);
         std::cout << "Upscaled image written to " << output_image << "\n";
+        if (cache) cache->store(cache_key, output_image.string());
     }
     catch (const std::exception& e) {
         std::cerr << "Error writing output image: " << e.what() << "\n";
@@ -0,0 +1,121 @@
+#include "multi_target.h"
+#include "jpeg_cpu.h"
+#include "lanczos.h"
+#include "tuning.h"
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <omp.h>
+
+namespace {
+    constexpr size_t max_pending_encodes = 2;
+
+    // Plain Lanczos goes through a Lanczos::Plan on the shared axis cache, so targets of
+    // equal width or height build that tap table once. Other filters, adaptive selection
+    // and the RGBX layout take the general Pipeline::resample path.
+    std::vector<unsigned char> resample_target(const std::vector<unsigned char>& image,
+                                               int width, int height, int channels,
+                                               int output_width, int output_height,
+                                               const Pipeline::Params& params, Lanczos::AxisCache& axes) {
+        if (params.filter != "lanczos" || params.adaptive_threshold > 0 || (params.rgbx && channels == 3)) {
+            return Pipeline::resample(image, width, height, channels, output_width, output_height, params);
+        }
+
+        Tuning::Config config;
+        std::optional<Tuning::ScopedConfig> scoped;
+        if (params.use_profile && Tuning::lookup(static_cast<long long>(output_width) * output_height, config)) {
+            scoped.emplace(config);
+        }
+        Lanczos::Plan plan(width, height, output_width, output_height, params.taps, params.precision, params.edge, &axes);
+        std::vector<unsigned char> output(static_cast<size_t>(output_width) * output_height * channels);
+        plan.run(image, channels, output, { 0, 0, output_width, output_height }, params.alpha);
+        return output;
+    }
+}
+
+namespace MultiTarget {
+    std::vector<Target> from_widths(const std::vector<int>& widths, int input_width, int input_height,
+                                    const std::string& output_prefix) {
+        std::vector<Target> targets;
+        for (int w : widths) {
+            Pipeline::Params params;
+            params.output_width = w;
+            Target target;
+            Pipeline::resolve_size(params, input_width, input_height, target.width, target.height);
+            target.output_path = output_prefix + "_" + std::to_string(target.width) + "x" + std::to_string(target.height) + ".jpg";
+            targets.push_back(target);
+        }
+        return targets;
+    }
+
+    std::vector<Result> run(const std::vector<unsigned char>& image,
+                            int width, int height, int channels,
+                            const std::vector<Target>& targets,
+                            const Pipeline::Params& params) {
+        std::vector<Result> results(targets.size());
+        for (size_t i = 0; i < targets.size(); ++i) {
+            Pipeline::Params size_params;
+            size_params.output_width = targets[i].width;
+            size_params.output_height = targets[i].height;
+            Pipeline::resolve_size(size_params, width, height, results[i].width, results[i].height);
+            results[i].output_path = targets[i].output_path;
+        }
+
+        // Largest first, so the biggest encode starts earliest and the tail is short.
+        std::vector<size_t> order(targets.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return static_cast<long long>(results[a].width) * results[a].height >
+                   static_cast<long long>(results[b].width) * results[b].height;
+        });
+
+        // Duplicate output paths are written once; count the remaining targets per size so
+        // a shared buffer leaves the map with its last target.
+        std::vector<size_t> jobs;
+        std::set<std::string> written;
+        std::map<std::pair<int, int>, int> users;
+        for (size_t i : order) {
+            if (!written.insert(results[i].output_path).second) continue;
+            jobs.push_back(i);
+            ++users[{ results[i].width, results[i].height }];
+        }
+
+        Lanczos::AxisCache axes;
+        std::map<std::pair<int, int>, std::shared_ptr<const std::vector<unsigned char>>> resampled;
+        std::deque<std::future<void>> encodes;
+        for (size_t i : jobs) {
+            Result& result = results[i];
+            auto key = std::make_pair(result.width, result.height);
+
+            auto found = resampled.find(key);
+            if (found == resampled.end()) {
+                // Bound the finished buffers still waiting for their encoder.
+                while (encodes.size() >= max_pending_encodes) {
+                    encodes.front().get();
+                    encodes.pop_front();
+                }
+                double start = omp_get_wtime();
+                auto buffer = std::make_shared<const std::vector<unsigned char>>(
+                    resample_target(image, width, height, channels, result.width, result.height, params, axes));
+                result.resample_ms = (omp_get_wtime() - start) * 1000.0;
+                found = resampled.emplace(key, buffer).first;
+            }
+
+            // The encoder holds the last reference, so the buffer is freed when it finishes.
+            std::shared_ptr<const std::vector<unsigned char>> buffer = found->second;
+            if (--users[key] == 0) resampled.erase(found);
+            int quality = params.quality;
+            encodes.push_back(std::async(std::launch::async, [buffer = std::move(buffer), result, channels, quality]() mutable {
+                JPEGProcessor::write_jpeg_file(result.output_path, *buffer, result.width, result.height, channels, quality);
+                buffer.reset();
+            }));
+        }
+
+        for (auto& encode : encodes) encode.get();
+        return results;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "pipeline.h"
+
+// One decoded source fanned out to several output sizes (responsive image sets).
+//
+// Targets are resampled largest first, each with the full OpenMP team, and every
+// finished result is handed to a background encoder so JPEG encoding of one target
+// overlaps the resampling of the next and the other encodes. Targets with the same
+// size share one resampled buffer; Lanczos targets of equal width or height share that
+// axis' tap tables. A buffer is freed as soon as its encode is done, and at most two
+// finished buffers wait for an encoder, so peak memory does not grow with the target count.
+namespace MultiTarget {
+    struct Target {
+        int width = 0;          // 0 = derive from height keeping aspect ratio
+        int height = 0;         // 0 = derive from width keeping aspect ratio
+        std::string output_path;
+    };
+
+    struct Result {
+        std::string output_path;
+        int width = 0;
+        int height = 0;
+        double resample_ms = 0.0;
+    };
+
+    std::vector<Result> run(const std::vector<unsigned char>& image,
+                            int width, int height, int channels,
+                            const std::vector<Target>& targets,
+                            const Pipeline::Params& params);
+
+    // Targets for a list of widths written to <prefix>_<w>x<h>.jpg.
+    std::vector<Target> from_widths(const std::vector<int>& widths, int input_width, int input_height,
+                                    const std::string& output_prefix);
+}
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "perf_counters.h"
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include <omp.h>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace PerfCounters {
+    namespace {
+        // Per-thread event state: raw value plus enabled/running times for multiplex scaling.
+        struct Counter {
+            uint64_t value = 0;
+            uint64_t enabled = 0;
+            uint64_t running = 0;
+        };
+
+        struct Totals {
+            Counter counter[EventCount];
+            bool seen[EventCount] = {};   // opened on at least one thread
+        };
+
+        std::mutex registry_mutex;
+        std::string reason;
+#ifdef __linux__
+        // thread id -> one fd per event (-1 when that event could not be opened)
+        std::map<pid_t, std::vector<int>> registry;
+        // Final readings of threads that have exited, so totals never go backwards.
+        Totals retired;
+
+        const char* const kEventNames[EventCount] = { "cycles", "instructions", "llc-misses", "branch-misses", "task-clock" };
+        const std::pair<uint32_t, uint64_t> kEvents[EventCount] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+        };
+
+        void accumulate(const std::vector<int>& fds, Totals& totals) {
+            for (int e = 0; e < EventCount; ++e) {
+                uint64_t data[3];
+                if (fds[e] < 0 || ::read(fds[e], data, sizeof(data)) != sizeof(data)) continue;
+                Counter& total = totals.counter[e];
+                total.value += data[0];
+                total.enabled += data[1];
+                total.running += data[2];
+                totals.seen[e] = true;
+            }
+        }
+
+        // Unregisters the thread at exit: its last values move to `retired`, fds are closed.
+        struct ThreadCounters {
+            pid_t tid = 0;
+            ~ThreadCounters() {
+                if (!tid) return;
+                std::lock_guard<std::mutex> lock(registry_mutex);
+                auto entry = registry.find(tid);
+                if (entry == registry.end()) return;
+                accumulate(entry->second, retired);
+                for (int fd : entry->second) {
+                    if (fd >= 0) close(fd);
+                }
+                registry.erase(entry);
+            }
+        };
+        thread_local ThreadCounters thread_counters;
+
+        // Opens the calling thread's counters once; they then run until the thread exits.
+        void attach_current_thread() {
+            if (thread_counters.tid) return;
+            pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            thread_counters.tid = tid;
+            // A thread that died without running its thread_local destructors may have left
+            // an entry under this (reused) id; retire it rather than read a dead thread's fds.
+            auto stale = registry.find(tid);
+            if (stale != registry.end()) {
+                accumulate(stale->second, retired);
+                for (int fd : stale->second) {
+                    if (fd >= 0) close(fd);
+                }
+                registry.erase(stale);
+            }
+
+            std::vector<int> fds(EventCount, -1);
+            for (int e = 0; e < EventCount; ++e) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = kEvents[e].first;
+                attr.config = kEvents[e].second;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                fds[e] = static_cast<int>(syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0));
+                if (fds[e] < 0 && reason.empty()) {
+                    reason = std::string("perf_event_open(") + kEventNames[e] + "): " + std::strerror(errno);
+                }
+            }
+            registry[tid] = fds;
+        }
+
+        void read_all(Totals& totals) {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            totals = retired;
+            for (const auto& entry : registry) accumulate(entry.second, totals);
+        }
+#endif
+    }
+
+    struct Scope::Baseline {
+        std::chrono::steady_clock::time_point start;
+#ifdef __linux__
+        Totals totals;
+#endif
+    };
+
+    double Reading::ipc() const {
+        if (!has(Cycles) || !has(Instructions) || value[Cycles] == 0) return 0.0;
+        return static_cast<double>(value[Instructions]) / value[Cycles];
+    }
+
+    double Reading::cpu_seconds() const {
+        return has(TaskClock) ? value[TaskClock] / 1e9 : 0.0;
+    }
+
+    std::string unavailable_reason() {
+#ifdef __linux__
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        return reason;
+#else
+        return "perf_event_open is Linux-only";
+#endif
+    }
+
+    Scope::Scope() : baseline(std::make_unique<Baseline>()) {
+#ifdef __linux__
+        attach_current_thread();
+        #pragma omp parallel
+        attach_current_thread();
+        read_all(baseline->totals);
+#endif
+        baseline->start = std::chrono::steady_clock::now();
+    }
+
+    Scope::~Scope() = default;
+
+    Reading Scope::stop() {
+        Reading reading;
+        reading.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - baseline->start).count();
+#ifdef __linux__
+        Totals totals;
+        read_all(totals);
+        for (int e = 0; e < EventCount; ++e) {
+            if (!totals.seen[e]) continue;
+            const Counter& now = totals.counter[e];
+            const Counter& then = baseline->totals.counter[e];
+            uint64_t running = now.running - then.running;
+            uint64_t enabled = now.enabled - then.enabled;
+            if (running == 0) continue;
+            // Scale up when the PMU multiplexed this event with others.
+            double scale = static_cast<double>(enabled) / running;
+            reading.value[e] = static_cast<uint64_t>((now.value - then.value) * scale);
+            reading.valid[e] = true;
+        }
+#endif
+        return reading;
+    }
+
+    std::string describe(const Reading& reading, double pixels) {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(2);
+        if (reading.has(Cycles) && reading.has(Instructions)) text << "ipc=" << reading.ipc() << " ";
+        if (reading.has(LlcMisses) && pixels > 0) {
+            text << "llc_miss/px=" << reading.value[LlcMisses] / pixels << " "
+                 << "dram_B/px=" << reading.value[LlcMisses] * 64.0 / pixels << " ";
+        }
+        if (reading.has(BranchMisses) && pixels > 0) text << "br_miss/px=" << reading.value[BranchMisses] / pixels << " ";
+        if (reading.has(TaskClock) && reading.seconds > 0) text << "cpu=" << reading.cpu_seconds() / reading.seconds << "x ";
+
+        std::string result = text.str();
+        if (!result.empty()) result.pop_back();
+        else result = "counters unavailable";
+        return result;
+    }
+}
\ No newline at end of file
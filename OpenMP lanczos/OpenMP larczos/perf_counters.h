@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Optional hardware counters (Linux perf_event_open) around a stage or parallel region.
+//
+// Counters are opened per thread, for the calling thread and every thread of its OpenMP
+// team, and summed; they count user space only, so perf_event_paranoid <= 2 suffices.
+// A thread's counters are closed when it exits, with its final values kept in the sums.
+// Each event is optional: on hosts without a PMU (most VMs and containers), without
+// permission, or off Linux, the affected fields stay invalid and callers print them as
+// unavailable. Idle OpenMP threads spin for a while before sleeping; those cycles are
+// counted too.
+namespace PerfCounters {
+    enum Event { Cycles, Instructions, LlcMisses, BranchMisses, TaskClock, EventCount };
+
+    struct Reading {
+        double seconds = 0.0;                 // wall time
+        uint64_t value[EventCount] = {};
+        bool valid[EventCount] = {};
+
+        bool has(Event event) const { return valid[event]; }
+        double ipc() const;                   // instructions / cycles
+        double cpu_seconds() const;           // summed thread CPU time (task clock)
+    };
+
+    // Empty when every event opened; otherwise why some or all are missing.
+    std::string unavailable_reason();
+
+    // Starts counting on construction; stop() returns the deltas since then.
+    class Scope {
+    public:
+        Scope();
+        ~Scope();
+        Reading stop();
+
+    private:
+        struct Baseline;
+        std::unique_ptr<Baseline> baseline;
+    };
+
+    // "ipc=1.23 llc_miss/px=0.41 dram_B/px=26.2 br_miss/px=0.01 cpu=3.9x" for the fields
+    // that are available; `pixels` is the output pixel count of the stage.
+    std::string describe(const Reading& reading, double pixels);
+}
\ No newline at end of file
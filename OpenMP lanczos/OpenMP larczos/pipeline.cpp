@@ -0,0 +1,156 @@
+#include "pipeline.h"
+#include "lanczos.h"
+#include "bicubic.h"
+#include "tuning.h"
+#include "tiled_raw.h"
+#include "jpeg_cpu.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace Pipeline {
+    std::vector<unsigned char> read_file_bytes(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Error opening input file: " + filename);
+        }
+        return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void resolve_size(const Params& params, int input_width, int input_height, int& output_width, int& output_height) {
+        output_width = params.output_width;
+        output_height = params.output_height;
+
+        // Keep the aspect ratio when only one dimension is given.
+        if (output_width > 0 && output_height <= 0) {
+            output_height = static_cast<int>(std::lround(static_cast<double>(input_height) * output_width / input_width));
+        }
+        else if (output_height > 0 && output_width <= 0) {
+            output_width = static_cast<int>(std::lround(static_cast<double>(input_width) * output_height / input_height));
+        }
+        else if (output_width <= 0 && output_height <= 0) {
+            if (params.scale <= 0.0f) {
+                throw std::invalid_argument("Either a target size or a positive scale factor is required");
+            }
+            output_width = static_cast<int>(input_width * params.scale);
+            output_height = static_cast<int>(input_height * params.scale);
+        }
+
+        if (output_width <= 0 || output_height <= 0) {
+            throw std::invalid_argument("Target size must be positive");
+        }
+    }
+
+    std::vector<unsigned char> resample(const std::vector<unsigned char>& input,
+                                        int input_width, int input_height, int channels,
+                                        int output_width, int output_height,
+                                        const Params& params) {
+        Tuning::Config config;
+        if (params.use_profile && Tuning::lookup(static_cast<long long>(output_width) * output_height, config)) {
+            Tuning::ScopedConfig scoped(config);
+            Params tuned = params;
+            tuned.use_profile = false;
+            // RGBX only changes float rounding, so keep double results (and cache keys) exact.
+            if (params.precision == Precision::Double) tuned.rgbx = params.rgbx || config.rgbx;
+            return resample(input, input_width, input_height, channels, output_width, output_height, tuned);
+        }
+
+        if (channels == 3 && params.rgbx) {
+            Params padded = params;
+            padded.rgbx = false;
+            padded.alpha = AlphaMode::Ignore;
+            std::vector<unsigned char> output = resample(PixelFormat::rgb_to_rgbx(input), input_width, input_height, 4,
+                                                         output_width, output_height, padded);
+            return PixelFormat::rgbx_to_rgb(output);
+        }
+
+        if (params.filter == "lanczos" && params.adaptive_threshold > 0 && params.taps > 2) {
+            return Lanczos::upscale_adaptive(input, input_width, input_height, channels, output_width, output_height, params.taps, params.adaptive_threshold, params.precision, params.edge, params.alpha);
+        }
+        if (params.filter == "lanczos") {
+            return Lanczos::upscale(input, input_width, input_height, channels, output_width, output_height, params.taps, params.precision, params.edge, params.alpha);
+        }
+        if (params.filter == "bicubic") {
+            return Bicubic::upscale(input, input_width, input_height, channels, output_width, output_height, params.precision, params.edge, params.alpha);
+        }
+        throw std::invalid_argument("Unknown filter: " + params.filter);
+    }
+
+    std::vector<unsigned char> resample(const unsigned char* input, size_t row_stride,
+                                        int input_width, int input_height, int channels,
+                                        int output_width, int output_height,
+                                        const Params& params) {
+        Tuning::Config config;
+        if (params.use_profile && Tuning::lookup(static_cast<long long>(output_width) * output_height, config)) {
+            Tuning::ScopedConfig scoped(config);
+            Params tuned = params;
+            tuned.use_profile = false;
+            if (params.precision == Precision::Double) tuned.rgbx = params.rgbx || config.rgbx;
+            return resample(input, row_stride, input_width, input_height, channels, output_width, output_height, tuned);
+        }
+
+        const bool packed_only = (channels == 3 && params.rgbx)
+            || (params.filter == "lanczos" && params.adaptive_threshold > 0 && params.taps > 2);
+        if (packed_only) {
+            const size_t row_values = static_cast<size_t>(input_width) * channels;
+            std::vector<unsigned char> packed(row_values * input_height);
+            for (int y = 0; y < input_height; ++y) {
+                std::copy_n(input + y * row_stride, row_values, &packed[y * row_values]);
+            }
+            return resample(packed, input_width, input_height, channels, output_width, output_height, params);
+        }
+
+        if (params.filter == "lanczos") {
+            return Lanczos::upscale(input, row_stride, input_width, input_height, channels, output_width, output_height, params.taps, params.precision, params.edge, params.alpha);
+        }
+        if (params.filter == "bicubic") {
+            return Bicubic::upscale(input, row_stride, input_width, input_height, channels, output_width, output_height, params.precision, params.edge, params.alpha);
+        }
+        throw std::invalid_argument("Unknown filter: " + params.filter);
+    }
+
+    void resample_tiled(const std::vector<unsigned char>& input,
+                        int input_width, int input_height, int channels,
+                        TiledRaw& output, const Params& params) {
+        Tuning::Config config;
+        if (params.use_profile && Tuning::lookup(static_cast<long long>(output.width()) * output.height(), config)) {
+            Tuning::ScopedConfig scoped(config);
+            Params tuned = params;
+            tuned.use_profile = false;
+            return resample_tiled(input, input_width, input_height, channels, output, tuned);
+        }
+
+        if (params.filter == "lanczos") {
+            return Lanczos::upscale_tiled(input, input_width, input_height, channels, output, params.taps, params.precision, params.edge, params.alpha);
+        }
+        if (params.filter == "bicubic") {
+            return Bicubic::upscale_tiled(input, input_width, input_height, channels, output, params.precision, params.edge, params.alpha);
+        }
+        throw std::invalid_argument("Unknown filter: " + params.filter);
+    }
+
+    void resample_streamed(const std::vector<unsigned char>& input,
+                           int input_width, int input_height, int channels,
+                           int output_width, int output_height,
+                           const Params& params, const std::string& output_path) {
+        const std::string tiles_path = output_path + ".tiles.tmp";
+        try {
+            TiledRaw tiles = TiledRaw::create(tiles_path, output_width, output_height, channels, Tiles::current_size());
+            resample_tiled(input, input_width, input_height, channels, tiles, params);
+            JPEGProcessor::write_jpeg_file_rows(output_path, output_width, output_height, channels, params.quality,
+                tiles.tile_size().height, [&tiles](int first_row, int rows, unsigned char* band) {
+                    tiles.read_rows(first_row, rows, band);
+                });
+        }
+        catch (...) {
+            std::error_code ignored;
+            std::filesystem::remove(tiles_path, ignored);
+            throw;
+        }
+        std::error_code ignored;
+        std::filesystem::remove(tiles_path, ignored);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "precision.h"
+#include "edge_mode.h"
+#include "pixel_format.h"
+
+class TiledRaw;
+
+// Shared resize parameters and the resample step used by the batch tools and the daemon.
+namespace Pipeline {
+    struct Params {
+        int output_width = 0;     // 0 = derive from scale
+        int output_height = 0;
+        float scale = 0.0f;
+        std::string filter = "lanczos"; // lanczos | bicubic
+        int taps = 8;             // Lanczos a
+        int quality = 90;
+        Precision precision = Precision::Double;
+        EdgeMode edge = EdgeMode::Clamp;
+        bool rgbx = false;        // resample RGB in the padded 4-byte layout
+        AlphaMode alpha = AlphaMode::Premultiply; // for caller-supplied RGBA; decoded JPEGs have 1 or 3 channels
+        bool use_profile = true;  // apply the host tuning profile (see tuning.h)
+        int adaptive_threshold = 0; // lanczos: Lanczos2 on tiles with no gradient >= this (0 = off, see adaptive.h)
+    };
+
+    std::vector<unsigned char> read_file_bytes(const std::string& filename);
+
+    void resolve_size(const Params& params, int input_width, int input_height, int& output_width, int& output_height);
+
+    std::vector<unsigned char> resample(const std::vector<unsigned char>& input,
+                                        int input_width, int input_height, int channels,
+                                        int output_width, int output_height,
+                                        const Params& params);
+
+    // Same, reading a borrowed buffer in place (rows start row_stride bytes apart). The
+    // RGBX and adaptive paths still work on a packed copy.
+    std::vector<unsigned char> resample(const unsigned char* input, size_t row_stride,
+                                        int input_width, int input_height, int channels,
+                                        int output_width, int output_height,
+                                        const Params& params);
+
+    // Resamples straight into a mapped tiled container; its size and tile grid define the
+    // output. The RGBX layout option does not apply (tiles keep the input channel count).
+    void resample_tiled(const std::vector<unsigned char>& input,
+                        int input_width, int input_height, int channels,
+                        TiledRaw& output, const Params& params);
+
+    // Lower-memory resample + encode: the output goes to a temporary tiled container next to
+    // output_path (file-backed, so its pages can be written back instead of staying
+    // resident) and is encoded from there one tile row at a time. Encoding is serial.
+    void resample_streamed(const std::vector<unsigned char>& input,
+                           int input_width, int input_height, int channels,
+                           int output_width, int output_height,
+                           const Params& params, const std::string& output_path);
+}
\ No newline at end of file
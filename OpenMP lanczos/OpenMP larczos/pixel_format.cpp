@@ -0,0 +1,32 @@
+#include "pixel_format.h"
+#include <cstddef>
+#include <omp.h>
+
+namespace PixelFormat {
+    std::vector<unsigned char> rgb_to_rgbx(const std::vector<unsigned char>& rgb) {
+        int pixels = static_cast<int>(rgb.size() / 3);
+        std::vector<unsigned char> rgbx(static_cast<size_t>(pixels) * 4);
+
+        #pragma omp parallel for
+        for (int i = 0; i < pixels; ++i) {
+            rgbx[i * 4 + 0] = rgb[i * 3 + 0];
+            rgbx[i * 4 + 1] = rgb[i * 3 + 1];
+            rgbx[i * 4 + 2] = rgb[i * 3 + 2];
+            rgbx[i * 4 + 3] = 255;
+        }
+        return rgbx;
+    }
+
+    std::vector<unsigned char> rgbx_to_rgb(const std::vector<unsigned char>& rgbx) {
+        int pixels = static_cast<int>(rgbx.size() / 4);
+        std::vector<unsigned char> rgb(static_cast<size_t>(pixels) * 3);
+
+        #pragma omp parallel for
+        for (int i = 0; i < pixels; ++i) {
+            rgb[i * 3 + 0] = rgbx[i * 4 + 0];
+            rgb[i * 3 + 1] = rgbx[i * 4 + 1];
+            rgb[i * 3 + 2] = rgbx[i * 4 + 2];
+        }
+        return rgb;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#include <vector>
+
+// Meaning of the fourth channel in 4-channel images.
+//   Ignore:      RGBX padding, resampled like any other channel (one aligned 32-bit lane per pixel)
+//   Premultiply: straight RGBA alpha, colours are resampled premultiplied by alpha
+enum class AlphaMode { Ignore, Premultiply };
+
+namespace PixelFormat {
+    // Pads packed RGB to RGBX with X = 255, so the result is also valid opaque RGBA.
+    std::vector<unsigned char> rgb_to_rgbx(const std::vector<unsigned char>& rgb);
+    std::vector<unsigned char> rgbx_to_rgb(const std::vector<unsigned char>& rgbx);
+}
\ No newline at end of file
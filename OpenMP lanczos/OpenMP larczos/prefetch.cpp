@@ -0,0 +1,257 @@
+#include "prefetch.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <filesystem> // Requires C++17
+#include <fstream>
+#include <future>
+#include <map>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define LANCZOS_HAVE_IO_URING 1
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+class Prefetcher::Backend {
+public:
+    virtual ~Backend() = default;
+    virtual void start(size_t slot, const std::string& path, size_t size) = 0;
+    virtual std::vector<unsigned char> wait(size_t slot) = 0;
+    virtual const char* name() const = 0;
+};
+
+namespace {
+    class ThreadBackend : public Prefetcher::Backend {
+    public:
+        explicit ThreadBackend(int depth)
+            : pool(std::min(depth, 4), static_cast<size_t>(std::max(depth, 1))) {}
+
+        void start(size_t slot, const std::string& path, size_t) override {
+            auto promise = std::make_shared<std::promise<std::vector<unsigned char>>>();
+            pending[slot] = promise->get_future();
+            pool.submit([promise, path] {
+                std::ifstream file(path, std::ios::binary);
+                std::vector<unsigned char> bytes;
+                if (file) bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                promise->set_value(std::move(bytes));
+            });
+        }
+
+        std::vector<unsigned char> wait(size_t slot) override {
+            auto bytes = pending[slot].get();
+            pending.erase(slot);
+            return bytes;
+        }
+
+        const char* name() const override { return "threads"; }
+
+    private:
+        WorkerPool pool;
+        std::map<size_t, std::future<std::vector<unsigned char>>> pending;
+    };
+
+#ifdef LANCZOS_HAVE_IO_URING
+    // Minimal io_uring driver on the raw syscalls: one IORING_OP_READ per file, resubmitted
+    // for the remainder on a short read.
+    class UringBackend : public Prefetcher::Backend {
+    public:
+        explicit UringBackend(unsigned entries) {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+            ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (ring_fd < 0) return;
+
+            sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single_mmap) sq_size = cq_size = std::max(sq_size, cq_size);
+
+            sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+            cq_ptr = single_mmap ? sq_ptr
+                                 : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+            if (sq_ptr == MAP_FAILED || cq_ptr == MAP_FAILED || sqes == MAP_FAILED) {
+                release();
+                return;
+            }
+
+            char* sq = static_cast<char*>(sq_ptr);
+            char* cq = static_cast<char*>(cq_ptr);
+            sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        }
+
+        ~UringBackend() override {
+            for (auto& [slot, read] : reads) {
+                while (read.in_flight) reap();
+            }
+            release();
+        }
+
+        bool ok() const { return ring_fd >= 0; }
+
+        void start(size_t slot, const std::string& path, size_t size) override {
+            Read& read = reads[slot];
+            read.fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            read.bytes.resize(size);
+            if (read.fd < 0 || size == 0) {
+                read.failed = (read.fd < 0);
+                return;
+            }
+            submit(slot, read);
+        }
+
+        std::vector<unsigned char> wait(size_t slot) override {
+            Read& read = reads[slot];
+            while (read.in_flight) reap();
+
+            std::vector<unsigned char> bytes;
+            if (!read.failed) {
+                read.bytes.resize(read.done);
+                bytes = std::move(read.bytes);
+            }
+            if (read.fd >= 0) close(read.fd);
+            reads.erase(slot);
+            return bytes;
+        }
+
+        const char* name() const override { return "io_uring"; }
+
+    private:
+        struct Read {
+            int fd = -1;
+            std::vector<unsigned char> bytes;
+            size_t done = 0;
+            bool in_flight = false;
+            bool failed = false;
+        };
+
+        void submit(size_t slot, Read& read) {
+            unsigned tail = *sq_tail;
+            unsigned index = tail & *sq_mask;
+            io_uring_sqe* sqe = &sqes[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = read.fd;
+            sqe->addr = reinterpret_cast<unsigned long long>(read.bytes.data() + read.done);
+            sqe->len = static_cast<unsigned>(std::min<size_t>(read.bytes.size() - read.done, 1u << 30));
+            sqe->off = read.done;
+            sqe->user_data = slot;
+            sq_array[index] = index;
+            __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+            read.in_flight = true;
+            if (syscall(__NR_io_uring_enter, ring_fd, 1, 0, 0, nullptr, 0) < 0) {
+                read.in_flight = false;
+                read.failed = true;
+            }
+        }
+
+        void reap() {
+            unsigned head = *cq_head;
+            while (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+                syscall(__NR_io_uring_enter, ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            }
+            io_uring_cqe cqe = cqes[head & *cq_mask];
+            __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+
+            auto it = reads.find(static_cast<size_t>(cqe.user_data));
+            if (it == reads.end()) return;
+            Read& read = it->second;
+            read.in_flight = false;
+            if (cqe.res < 0) {
+                read.failed = true;
+            }
+            else if (cqe.res > 0) {
+                read.done += static_cast<size_t>(cqe.res);
+                if (read.done < read.bytes.size()) submit(it->first, read); // short read
+            }
+        }
+
+        void release() {
+            if (sqes && sqes != MAP_FAILED) munmap(sqes, sqes_size);
+            if (cq_ptr && cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) munmap(cq_ptr, cq_size);
+            if (sq_ptr && sq_ptr != MAP_FAILED) munmap(sq_ptr, sq_size);
+            if (ring_fd >= 0) close(ring_fd);
+            ring_fd = -1;
+        }
+
+        int ring_fd = -1;
+        void* sq_ptr = nullptr;
+        void* cq_ptr = nullptr;
+        size_t sq_size = 0, cq_size = 0, sqes_size = 0;
+        io_uring_sqe* sqes = nullptr;
+        unsigned *sq_tail = nullptr, *sq_mask = nullptr, *sq_array = nullptr;
+        unsigned *cq_head = nullptr, *cq_tail = nullptr, *cq_mask = nullptr;
+        io_uring_cqe* cqes = nullptr;
+        std::map<size_t, Read> reads;
+    };
+#endif
+}
+
+Prefetcher::Prefetcher(std::vector<std::string> paths, Options options)
+    : paths(std::move(paths)), options(options) {
+    this->options.depth = std::max(this->options.depth, 1);
+
+    sizes.resize(this->paths.size());
+    for (size_t i = 0; i < this->paths.size(); ++i) {
+        std::error_code ec;
+        auto size = fs::file_size(this->paths[i], ec);
+        sizes[i] = ec ? 0 : static_cast<size_t>(size);
+    }
+
+#ifdef LANCZOS_HAVE_IO_URING
+    if (this->options.use_io_uring) {
+        auto uring = std::make_unique<UringBackend>(static_cast<unsigned>(this->options.depth));
+        if (uring->ok()) reader = std::move(uring);
+    }
+#endif
+    if (!reader) reader = std::make_unique<ThreadBackend>(this->options.depth);
+
+    refill();
+}
+
+Prefetcher::~Prefetcher() {
+    // Drain outstanding reads before their buffers go away.
+    while (consumed < issued) {
+        reader->wait(consumed);
+        ++consumed;
+    }
+}
+
+void Prefetcher::refill() {
+    while (issued < paths.size() && issued - consumed < static_cast<size_t>(options.depth)) {
+        bool idle = (issued == consumed);
+        if (!idle && bytes_in_flight + sizes[issued] > options.memory_budget) break;
+        reader->start(issued, paths[issued], sizes[issued]);
+        bytes_in_flight += sizes[issued];
+        ++issued;
+    }
+}
+
+bool Prefetcher::next(std::string& path, std::vector<unsigned char>& bytes) {
+    if (consumed >= paths.size()) return false;
+
+    bytes = reader->wait(consumed);
+    path = paths[consumed];
+    bytes_in_flight -= sizes[consumed];
+    ++consumed;
+    refill();
+    return true;
+}
+
+const char* Prefetcher::backend() const {
+    return reader->name();
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Reads the next files of a batch into memory ahead of the consumer, so decode and
+// resample overlap storage latency. On Linux reads are queued through io_uring; when it
+// is unavailable (older kernels, seccomp, other platforms) a small thread pool issues
+// ordinary blocking reads instead. At most `depth` files, and at most `memory_budget`
+// bytes, are in flight or buffered at once (a single file larger than the budget is
+// still read, alone).
+class Prefetcher {
+public:
+    struct Options {
+        int depth = 8;
+        size_t memory_budget = 256u * 1024 * 1024;
+        bool use_io_uring = true;
+    };
+
+    Prefetcher(std::vector<std::string> paths, Options options);
+    ~Prefetcher();
+
+    Prefetcher(const Prefetcher&) = delete;
+    Prefetcher& operator=(const Prefetcher&) = delete;
+
+    // Next file in input order; false once every file has been returned. A file that
+    // could not be read comes back with empty bytes.
+    bool next(std::string& path, std::vector<unsigned char>& bytes);
+
+    const char* backend() const;
+
+    class Backend;
+
+private:
+    void refill();
+
+    std::vector<std::string> paths;
+    std::vector<size_t> sizes;
+    Options options;
+    size_t issued = 0;
+    size_t consumed = 0;
+    size_t bytes_in_flight = 0;
+    std::unique_ptr<Backend> reader;
+};
\ No newline at end of file
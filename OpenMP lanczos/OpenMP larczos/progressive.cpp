@@ -0,0 +1,142 @@
+#include "progressive.h"
+#include "jpeg_cpu.h"
+#include "lanczos.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace Progressive {
+    namespace {
+        // Source index pair and 8-bit fraction per output coordinate (pixel-centre aligned).
+        void bilinear_axis(int input_size, int output_size, std::vector<int>& lo, std::vector<int>& hi, std::vector<int>& fraction) {
+            lo.resize(output_size);
+            hi.resize(output_size);
+            fraction.resize(output_size);
+            const float ratio = static_cast<float>(input_size) / output_size;
+            for (int i = 0; i < output_size; ++i) {
+                float position = std::clamp((i + 0.5f) * ratio - 0.5f, 0.0f, static_cast<float>(input_size - 1));
+                lo[i] = static_cast<int>(position);
+                hi[i] = std::min(lo[i] + 1, input_size - 1);
+                fraction[i] = static_cast<int>((position - lo[i]) * 256.0f + 0.5f);
+            }
+        }
+
+        // Fixed-point bilinear stretch: two horizontal lerps and one vertical lerp per value,
+        // a few times cheaper than the generic separable path. Preview quality only.
+        std::vector<unsigned char> bilinear(const std::vector<unsigned char>& input,
+                                            int input_width, int input_height, int channels,
+                                            int output_width, int output_height) {
+            std::vector<int> x_lo, x_hi, x_fraction, y_lo, y_hi, y_fraction;
+            bilinear_axis(input_width, output_width, x_lo, x_hi, x_fraction);
+            bilinear_axis(input_height, output_height, y_lo, y_hi, y_fraction);
+
+            const size_t row_values = static_cast<size_t>(output_width) * channels;
+            std::vector<unsigned char> output(row_values * output_height);
+
+            #pragma omp parallel
+            {
+                std::vector<int> top(row_values), bottom(row_values);
+                auto horizontal = [&](int y, std::vector<int>& row) {
+                    const unsigned char* source = &input[static_cast<size_t>(y) * input_width * channels];
+                    for (int x = 0; x < output_width; ++x) {
+                        const unsigned char* a = source + static_cast<size_t>(x_lo[x]) * channels;
+                        const unsigned char* b = source + static_cast<size_t>(x_hi[x]) * channels;
+                        for (int c = 0; c < channels; ++c) {
+                            row[static_cast<size_t>(x) * channels + c] = a[c] * 256 + (b[c] - a[c]) * x_fraction[x];
+                        }
+                    }
+                };
+
+                // Static schedule gives each thread consecutive rows, so when upscaling most
+                // output rows reuse the previous row's horizontally stretched source rows.
+                int top_y = -1, bottom_y = -1;
+                #pragma omp for schedule(static)
+                for (int y = 0; y < output_height; ++y) {
+                    if (y_lo[y] == bottom_y && y_lo[y] != top_y) {
+                        std::swap(top, bottom);
+                        std::swap(top_y, bottom_y);
+                    }
+                    if (top_y != y_lo[y]) horizontal(top_y = y_lo[y], top);
+                    if (bottom_y != y_hi[y]) horizontal(bottom_y = y_hi[y], bottom);
+                    const int fy = y_fraction[y];
+                    unsigned char* out = &output[static_cast<size_t>(y) * row_values];
+                    for (size_t i = 0; i < row_values; ++i) {
+                        out[i] = static_cast<unsigned char>((top[i] * (256 - fy) + bottom[i] * fy + 32768) >> 16);
+                    }
+                }
+            }
+            return output;
+        }
+
+        // Largest DCT scale that still leaves the preview within 4x of the output size.
+        int preview_denominator(int input_width, int input_height, int output_width, int output_height) {
+            for (int denom : { 8, 4, 2 }) {
+                int w = (input_width + denom - 1) / denom;
+                int h = (input_height + denom - 1) / denom;
+                if (w * 4 >= output_width && h * 4 >= output_height) return denom;
+            }
+            return 1;
+        }
+
+        class ScopedCancel {
+        public:
+            explicit ScopedCancel(const std::atomic<bool>* flag) : saved(Tiles::current_cancel()) { Tiles::current_cancel() = flag; }
+            ~ScopedCancel() { Tiles::current_cancel() = saved; }
+
+        private:
+            const std::atomic<bool>* saved;
+        };
+    }
+
+    bool run(const std::vector<unsigned char>& jpeg_bytes, const Pipeline::Params& params,
+             const Callbacks& callbacks, std::vector<unsigned char>& image,
+             int& width, int& height, int& channels,
+             const std::atomic<bool>* cancel) {
+        auto cancelled = [cancel] { return cancel && cancel->load(); };
+
+        int input_width = 0, input_height = 0;
+        if (!JPEGProcessor::read_jpeg_header(jpeg_bytes, input_width, input_height, channels)) {
+            throw std::runtime_error("Could not read JPEG header");
+        }
+        Pipeline::resolve_size(params, input_width, input_height, width, height);
+
+        // Preview: DCT-scaled decode, bilinear stretch.
+        const int denom = preview_denominator(input_width, input_height, width, height);
+        std::vector<unsigned char> source;
+        int source_width = 0, source_height = 0, source_channels = 0;
+        JPEGProcessor::read_jpeg_memory(jpeg_bytes, source, source_width, source_height, source_channels, denom);
+        if (source.empty()) throw std::runtime_error("Could not decode JPEG");
+
+        image = bilinear(source, source_width, source_height, channels, width, height);
+        if (callbacks.preview) callbacks.preview(image, width, height, channels);
+        if (cancelled()) return false;
+
+        // Refinement: full decode (unless the preview already used it), Lanczos in place.
+        if (denom != 1) {
+            JPEGProcessor::read_jpeg_memory(jpeg_bytes, source, source_width, source_height, source_channels);
+            if (source.empty()) throw std::runtime_error("Could not decode JPEG");
+        }
+
+        std::mutex callback_mutex;
+        ScopedCancel scoped(cancel);
+        Lanczos::upscale_tiles(source, source_width, source_height, channels, image, width, height,
+            [&](const Tiles::Tile& tile) {
+                if (!callbacks.tile) return;
+                // Other threads are still writing the rest of `image`; hand out only this tile.
+                thread_local std::vector<unsigned char> pixels;
+                const size_t tile_row = static_cast<size_t>(tile.x1 - tile.x0) * channels;
+                pixels.resize(tile_row * (tile.y1 - tile.y0));
+                for (int y = tile.y0; y < tile.y1; ++y) {
+                    std::copy_n(&image[(static_cast<size_t>(y) * width + tile.x0) * channels], tile_row,
+                                &pixels[static_cast<size_t>(y - tile.y0) * tile_row]);
+                }
+                std::lock_guard<std::mutex> lock(callback_mutex);
+                callbacks.tile(tile, pixels);
+            },
+            params.taps, params.precision, params.edge, params.alpha);
+        return !cancelled();
+    }
+
+}
\ No newline at end of file
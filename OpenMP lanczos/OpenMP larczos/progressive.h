@@ -0,0 +1,30 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "pipeline.h"
+#include "tiles.h"
+
+// Preview-then-refine resize for interactive use (always refines with Lanczos, a = taps).
+//
+// A cheap frame arrives first: the JPEG is decoded at 1/2, 1/4 or 1/8 size in the DCT
+// domain and stretched to the output size bilinearly. The full-size decode is then
+// refined to the Lanczos result in place, tile by tile; each finished tile is reported
+// so a viewer can repaint just that rectangle. Setting `cancel` (e.g. when the request is
+// superseded) stops refinement after the tiles already in progress.
+namespace Progressive {
+    struct Callbacks {
+        // Called once, before any tile, with the whole preview frame.
+        std::function<void(const std::vector<unsigned char>& image, int width, int height, int channels)> preview;
+        // Called as each tile is refined with a copy of just that tile's pixels, rows packed
+        // at (x1 - x0) * channels. Calls are serialized but come from worker threads.
+        std::function<void(const Tiles::Tile& tile, const std::vector<unsigned char>& pixels)> tile;
+    };
+
+    // Returns true when the whole frame was refined, false when cancelled. `image` ends
+    // up holding the refined (or partially refined) frame.
+    bool run(const std::vector<unsigned char>& jpeg_bytes, const Pipeline::Params& params,
+             const Callbacks& callbacks, std::vector<unsigned char>& image,
+             int& width, int& height, int& channels,
+             const std::atomic<bool>* cancel = nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <filesystem> // Requires C++17
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Thin client for the resize daemon. Takes the same arguments as main_args so scripts
+// can switch over by changing only the executable name; further daemon options (see
+// daemon.h) are passed through as key=value arguments.
+// The socket path comes from LANCZOS_SOCKET (default /tmp/lanczos.sock).
+
+namespace fs = std::filesystem;
+
+#ifdef _WIN32
+int main() {
+    std::cerr << "The resize client requires Unix domain sockets and is not supported on this platform.\n";
+    return 1;
+}
+#else
+int main(int argc, char* argv[]) {
+    bool stats = (argc == 2 && std::string(argv[1]) == "--stats");
+    bool shutdown = (argc == 2 && std::string(argv[1]) == "--shutdown");
+    std::string options;
+    bool valid = stats || shutdown || argc >= 4;
+    for (int i = 4; valid && !stats && !shutdown && i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "float" || option == "double") option = "precision=" + option;
+        size_t eq = option.find('=');
+        valid = eq != std::string::npos && eq > 0 && option.find('\n') == std::string::npos
+             && option.compare(0, eq, "command") != 0 && option.compare(0, eq, "input") != 0
+             && option.compare(0, eq, "output") != 0 && option.compare(0, eq, "length") != 0;
+        options += option + "\n";
+    }
+    if (!valid) {
+        std::cerr << "Usage: " << argv[0] << " <input_image> <output_image> <scale_factor> [float|double] [key=value]...\n"
+                  << "       " << argv[0] << " --stats | --shutdown\n";
+        return 1;
+    }
+
+    const char* env_socket = std::getenv("LANCZOS_SOCKET");
+    std::string socket_path = env_socket ? env_socket : "/tmp/lanczos.sock";
+
+    std::string request;
+    if (stats) {
+        request = "command=stats\n\n";
+    }
+    else if (shutdown) {
+        request = "command=shutdown\n\n";
+    }
+    else {
+        // The daemon has its own working directory, so send absolute paths.
+        request = "command=resize\n"
+                  "input=" + fs::absolute(argv[1]).string() + "\n"
+                  "output=" + fs::absolute(argv[2]).string() + "\n"
+                  "scale=" + std::string(argv[3]) + "\n" + options + "\n";
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    socket_path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "Could not connect to resize daemon at " << socket_path << "\n";
+        return 1;
+    }
+
+    size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = write(fd, request.data() + sent, request.size() - sent);
+        if (n <= 0) break;
+        sent += static_cast<size_t>(n);
+    }
+
+    std::string reply;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        reply.append(buffer, static_cast<size_t>(n));
+    }
+    close(fd);
+
+    if (reply.rfind("ERR", 0) == 0 || reply.empty()) {
+        std::cerr << (reply.empty() ? "No reply from resize daemon\n" : reply);
+        return 1;
+    }
+    std::cout << reply;
+    return 0;
+}
+#endif
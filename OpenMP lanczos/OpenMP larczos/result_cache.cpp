@@ -0,0 +1,141 @@
+#include "result_cache.h"
+#include "jpeg_cpu.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem> // Requires C++17
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // 64-bit FNV-1a over eight bytes per step; plenty for cache keys and cheap next to decode.
+    uint64_t hash_bytes(const unsigned char* data, size_t size, uint64_t hash = 1469598103934665603ULL) {
+        const uint64_t prime = 1099511628211ULL;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word = 0;
+            for (int b = 0; b < 8; ++b) word |= static_cast<uint64_t>(data[i + b]) << (8 * b);
+            hash = (hash ^ word) * prime;
+            hash ^= hash >> 29;
+        }
+        for (; i < size; ++i) {
+            hash = (hash ^ data[i]) * prime;
+        }
+        return hash;
+    }
+
+    std::string to_hex(uint64_t value) {
+        std::ostringstream out;
+        out << std::hex << std::setw(16) << std::setfill('0') << value;
+        return out.str();
+    }
+}
+
+ResultCache::ResultCache(const std::string& directory, uint64_t max_bytes)
+    : directory(directory), max_bytes(max_bytes) {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+}
+
+std::unique_ptr<ResultCache> ResultCache::from_environment() {
+    const char* dir = std::getenv("LANCZOS_CACHE_DIR");
+    if (!dir || !*dir) return nullptr;
+
+    uint64_t max_mb = 1024;
+    if (const char* mb = std::getenv("LANCZOS_CACHE_MAX_MB")) {
+        max_mb = std::strtoull(mb, nullptr, 10);
+    }
+    return std::make_unique<ResultCache>(dir, max_mb * 1024 * 1024);
+}
+
+std::string ResultCache::key(const std::vector<unsigned char>& input_bytes, const Pipeline::Params& params) const {
+    // Key on the resolved output size rather than the scale as printed (6 significant
+    // digits); an unreadable header keeps the request as given, the decode fails anyway.
+    int output_width = params.output_width, output_height = params.output_height;
+    int input_width = 0, input_height = 0, channels = 0;
+    if (JPEGProcessor::read_jpeg_header(input_bytes, input_width, input_height, channels)) {
+        Pipeline::resolve_size(params, input_width, input_height, output_width, output_height);
+    }
+
+    // Bump the version prefix whenever resampler output changes for the same parameters.
+    std::ostringstream description;
+    description << "v3|" << output_width << "x" << output_height
+                << "|" << params.filter << "|a" << params.taps
+                << "|q" << params.quality << "|" << precision_name(params.precision)
+                << "|" << edge_mode_name(params.edge)
+                << (params.rgbx ? "|rgbx" : "|rgb")
+                << (params.alpha == AlphaMode::Premultiply ? "|premultiply" : "|ignore");
+    if (params.adaptive_threshold > 0) description << "|adaptive" << params.adaptive_threshold;
+    std::string text = description.str();
+
+    uint64_t content = hash_bytes(input_bytes.data(), input_bytes.size());
+    uint64_t settings = hash_bytes(reinterpret_cast<const unsigned char*>(text.data()), text.size(), content);
+    return to_hex(content) + to_hex(settings);
+}
+
+std::string ResultCache::entry_path(const std::string& key) const {
+    return (fs::path(directory) / (key + ".jpg")).string();
+}
+
+bool ResultCache::fetch(const std::string& key, const std::string& output_path) {
+    std::error_code ec;
+    fs::path entry = entry_path(key);
+    if (!fs::copy_file(entry, output_path, fs::copy_options::overwrite_existing, ec) || ec) {
+        return false;
+    }
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+void ResultCache::store(const std::string& key, const std::string& produced_path) {
+    static std::atomic<unsigned> counter{ 0 };
+
+    // Unique per process and thread so concurrent writers never share a temp file;
+    // the final rename is atomic, so readers see either nothing or a complete entry.
+    std::ostringstream temp_name;
+    temp_name << key << ".tmp." << std::hash<std::thread::id>()(std::this_thread::get_id())
+              << "." << std::chrono::steady_clock::now().time_since_epoch().count()
+              << "." << counter++;
+    fs::path temp = fs::path(directory) / temp_name.str();
+
+    std::error_code ec;
+    fs::copy_file(produced_path, temp, fs::copy_options::overwrite_existing, ec);
+    if (ec) return;
+    fs::rename(temp, entry_path(key), ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        return;
+    }
+    evict();
+}
+
+void ResultCache::evict() {
+    struct Entry {
+        fs::path path;
+        fs::file_time_type used;
+        uintmax_t size;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const auto& item : fs::directory_iterator(directory, ec)) {
+        if (!item.is_regular_file(ec) || item.path().extension() != ".jpg") continue;
+        Entry entry{ item.path(), item.last_write_time(ec), item.file_size(ec) };
+        if (ec) continue;
+        total += entry.size;
+        entries.push_back(entry);
+    }
+    if (total <= max_bytes) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const auto& entry : entries) {
+        if (total <= max_bytes) break;
+        if (fs::remove(entry.path, ec)) total -= entry.size;
+    }
+}
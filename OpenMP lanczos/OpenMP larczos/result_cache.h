@@ -0,0 +1,31 @@
+#pragma once
+#include "pipeline.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Content-addressed cache of encoded results. Entries are keyed by a hash of the source
+// JPEG bytes plus the resolved output size and every other resize parameter, written
+// atomically (temp file + rename) and evicted least-recently-used once the directory
+// exceeds max_bytes. A hit refreshes the entry's modification time, which is what the
+// LRU order is based on, so several processes can safely share one directory.
+class ResultCache {
+public:
+    ResultCache(const std::string& directory, uint64_t max_bytes);
+
+    // LANCZOS_CACHE_DIR enables the cache; LANCZOS_CACHE_MAX_MB caps it (default 1024).
+    static std::unique_ptr<ResultCache> from_environment();
+
+    std::string key(const std::vector<unsigned char>& input_bytes, const Pipeline::Params& params) const;
+
+    bool fetch(const std::string& key, const std::string& output_path);
+    void store(const std::string& key, const std::string& produced_path);
+
+private:
+    std::string entry_path(const std::string& key) const;
+    void evict();
+
+    std::string directory;
+    uint64_t max_bytes;
+};
@@ -0,0 +1,205 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "edge_mode.h"
+#include "pixel_format.h"
+#include "tiles.h"
+
+// Shared tap tables for the separable CPU resamplers (Lanczos, Bicubic).
+//
+// Each output column/row gets `taps` consecutive source positions starting at first[i],
+// with weights precomputed once per axis instead of once per tap per channel. Outputs
+// whose whole footprint lies inside the source on both axes form a single interior
+// rectangle; each tile row is split into its border and interior spans up front, and the
+// interior span runs a clamp-free kernel that walks the source with plain pointer
+// arithmetic. Only the thin border frame goes through the edge-mapped index table.
+// Work is distributed over output tiles (see tiles.h).
+namespace Separable {
+    template <typename T>
+    struct Axis {
+        int taps = 0;
+        std::vector<int> first;   // first source index per output (may be out of range)
+        std::vector<int> index;   // edge-resolved source index per output and tap
+        std::vector<T> weight;    // weight per output and tap
+        int interior_begin = 0;   // outputs in [interior_begin, interior_end) need no edge handling
+        int interior_end = 0;
+    };
+
+    // position(i) maps output index i to the source coordinate; tap k of output i sits at
+    // first_tap(position) + k and is weighted by kernel(position - source_index).
+    template <typename T, typename Position, typename FirstTap, typename Kernel>
+    Axis<T> build_axis(int input_size, int output_size, int taps, EdgeMode edge,
+                       Position position, FirstTap first_tap, Kernel kernel) {
+        Axis<T> axis;
+        axis.taps = taps;
+        axis.first.resize(output_size);
+        axis.index.resize(static_cast<size_t>(output_size) * taps);
+        axis.weight.resize(static_cast<size_t>(output_size) * taps);
+        axis.interior_begin = output_size;
+        axis.interior_end = output_size;
+
+        bool seen_interior = false;
+        for (int i = 0; i < output_size; ++i) {
+            T center = position(i);
+            int first = first_tap(center);
+            axis.first[i] = first;
+            for (int k = 0; k < taps; ++k) {
+                axis.index[static_cast<size_t>(i) * taps + k] = resolve_edge(first + k, input_size, edge);
+                axis.weight[static_cast<size_t>(i) * taps + k] = kernel(center - (first + k));
+            }
+
+            // first is monotonic in i, so the interior outputs are contiguous.
+            bool interior = first >= 0 && first + taps <= input_size;
+            if (interior && !seen_interior) {
+                axis.interior_begin = i;
+                seen_interior = true;
+            }
+            if (interior) axis.interior_end = i + 1;
+        }
+        if (!seen_interior) axis.interior_begin = axis.interior_end = 0;
+        return axis;
+    }
+
+    // C is the compile-time channel count so all channels of a tap are accumulated together
+    // (one 32-bit lane per pixel for RGBX/RGBA). With Premultiply the fourth channel is
+    // straight alpha: colours are weighted by it during accumulation and divided back out,
+    // which avoids dark fringes around transparent regions.
+    //
+    // `destination(tile, y)` returns where pixel (tile.x0, y) is stored; the rest of the
+    // tile's row follows contiguously. This lets the same loop fill a row-major buffer or
+    // the tiles of a TiledRaw container.
+    template <typename T, int C, bool Premultiply, typename Destination>
+    void resample_tile(const unsigned char* source, size_t row_stride,
+                       const Axis<T>& x_axis, const Axis<T>& y_axis,
+                       const Tiles::Tile& tile, Destination& destination) {
+        const int x_taps = x_axis.taps;
+        const int y_taps = y_axis.taps;
+
+        // `interior` is a std::bool_constant, so each span gets its own branch-free loop.
+        auto pixel = [&](auto interior, int x, int y, unsigned char* out) {
+            const T* wx = &x_axis.weight[static_cast<size_t>(x) * x_taps];
+            const T* wy = &y_axis.weight[static_cast<size_t>(y) * y_taps];
+
+            T sum[C] = {};
+            T normalizer = 0;
+            auto accumulate = [&](const unsigned char* p, T weight) {
+                if constexpr (Premultiply) {
+                    T weighted_alpha = weight * p[3];
+                    for (int c = 0; c < 3; ++c) sum[c] += weighted_alpha * p[c];
+                    sum[3] += weighted_alpha;
+                }
+                else {
+                    for (int c = 0; c < C; ++c) sum[c] += weight * p[c];
+                }
+                normalizer += weight;
+            };
+
+            if constexpr (decltype(interior)::value) {
+                const unsigned char* row = source + y_axis.first[y] * row_stride
+                                         + static_cast<size_t>(x_axis.first[x]) * C;
+                for (int n = 0; n < y_taps; ++n, row += row_stride) {
+                    const unsigned char* p = row;
+                    for (int m = 0; m < x_taps; ++m, p += C) {
+                        accumulate(p, wx[m] * wy[n]);
+                    }
+                }
+            }
+            else {
+                const int* ix = &x_axis.index[static_cast<size_t>(x) * x_taps];
+                const int* iy = &y_axis.index[static_cast<size_t>(y) * y_taps];
+                for (int n = 0; n < y_taps; ++n) {
+                    const unsigned char* row = source + iy[n] * row_stride;
+                    for (int m = 0; m < x_taps; ++m) {
+                        accumulate(row + static_cast<size_t>(ix[m]) * C, wx[m] * wy[n]);
+                    }
+                }
+            }
+
+            if constexpr (Premultiply) {
+                for (int c = 0; c < 3; ++c) {
+                    T color = (sum[3] > T(0)) ? sum[c] / sum[3] : T(0);
+                    out[c] = static_cast<unsigned char>(std::clamp(color, T(0), T(255)));
+                }
+                out[3] = static_cast<unsigned char>(std::clamp(sum[3] / normalizer, T(0), T(255)));
+            }
+            else {
+                for (int c = 0; c < C; ++c) {
+                    out[c] = static_cast<unsigned char>(std::clamp(sum[c] / normalizer, T(0), T(255)));
+                }
+            }
+        };
+
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            // Interior span of this row: [x_begin, x_end), empty on border rows.
+            int x_begin = tile.x1, x_end = tile.x1;
+            if (y >= y_axis.interior_begin && y < y_axis.interior_end) {
+                x_begin = std::clamp(x_axis.interior_begin, tile.x0, tile.x1);
+                x_end = std::clamp(x_axis.interior_end, x_begin, tile.x1);
+            }
+
+            unsigned char* out = destination(tile, y);
+            int x = tile.x0;
+            for (; x < x_begin; ++x, out += C) pixel(std::false_type(), x, y, out);
+            for (; x < x_end; ++x, out += C) pixel(std::true_type(), x, y, out);
+            for (; x < tile.x1; ++x, out += C) pixel(std::false_type(), x, y, out);
+        }
+    }
+
+    template <typename T, int C, bool Premultiply, typename Destination>
+    void resample_pixels(const unsigned char* source, size_t row_stride,
+                         const Axis<T>& x_axis, const Axis<T>& y_axis,
+                         Tiles::Size tile_size, Destination destination) {
+        const int output_width = static_cast<int>(x_axis.first.size());
+        const int output_height = static_cast<int>(y_axis.first.size());
+        Tiles::parallel_for(output_width, output_height, tile_size, [&](const Tiles::Tile& tile) {
+            resample_tile<T, C, Premultiply>(source, row_stride, x_axis, y_axis, tile, destination);
+        });
+    }
+
+    // Calls fn(std::integral_constant<int, C>, std::integral_constant<bool, Premultiply>)
+    // for a runtime channel count, so callers instantiate the pixel loop once per layout.
+    template <typename Fn>
+    void dispatch_channels(int channels, AlphaMode alpha, Fn fn) {
+        switch (channels) {
+        case 1: fn(std::integral_constant<int, 1>(), std::false_type()); break;
+        case 2: fn(std::integral_constant<int, 2>(), std::false_type()); break;
+        case 3: fn(std::integral_constant<int, 3>(), std::false_type()); break;
+        case 4:
+            if (alpha == AlphaMode::Premultiply) fn(std::integral_constant<int, 4>(), std::true_type());
+            else fn(std::integral_constant<int, 4>(), std::false_type());
+            break;
+        default:
+            throw std::invalid_argument("Unsupported channel count: " + std::to_string(channels));
+        }
+    }
+
+    // `row_stride` is the distance in bytes between source rows, so borrowed or padded
+    // buffers are read in place.
+    template <typename T, typename Destination>
+    void resample_into(const unsigned char* input, size_t row_stride, int channels,
+                       const Axis<T>& x_axis, const Axis<T>& y_axis,
+                       AlphaMode alpha, Tiles::Size tile_size, Destination destination) {
+        dispatch_channels(channels, alpha, [&](auto c, auto premultiply) {
+            resample_pixels<T, decltype(c)::value, decltype(premultiply)::value>(
+                input, row_stride, x_axis, y_axis, tile_size, destination);
+        });
+    }
+
+    template <typename T>
+    std::vector<unsigned char> resample(const unsigned char* input, size_t row_stride, int channels,
+                                        const Axis<T>& x_axis, const Axis<T>& y_axis,
+                                        AlphaMode alpha, Tiles::Size tile_size = Tiles::current_size()) {
+        const size_t output_width = x_axis.first.size();
+        std::vector<unsigned char> output(output_width * y_axis.first.size() * channels);
+        unsigned char* data = output.data();
+
+        resample_into(input, row_stride, channels, x_axis, y_axis, alpha, tile_size,
+            [=](const Tiles::Tile& tile, int y) {
+                return data + (static_cast<size_t>(y) * output_width + tile.x0) * channels;
+            });
+        return output;
+    }
+}
\ No newline at end of file
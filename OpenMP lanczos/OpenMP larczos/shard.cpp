@@ -0,0 +1,401 @@
+#include "shard.h"
+#include "batch.h"
+#include "jpeg_cpu.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#ifndef _WIN32
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem> // Requires C++17
+#include <map>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace ShardedBatch {
+#ifdef _WIN32
+    int coordinate(const Options&) {
+        std::cerr << "Sharded batch mode requires POSIX shared memory and is not supported on this platform.\n";
+        return 1;
+    }
+
+    int work(const std::string&) {
+        std::cerr << "Sharded batch mode requires POSIX shared memory and is not supported on this platform.\n";
+        return 1;
+    }
+#else
+    namespace {
+        namespace fs = std::filesystem;
+
+        const uint32_t kMagic = 0x4c5a5348; // "LZSH"
+        const int kMaxWorkers = 64;
+        const size_t kPathSize = 512;
+
+        // Job state word: one of the values below, or kClaimed + worker slot. Keeping the
+        // owner in the same word makes claim and release a single CAS.
+        const uint32_t kPending = 0;
+        const uint32_t kDone = 1;
+        const uint32_t kFailed = 2;
+        const uint32_t kRequeuing = 3;          // coordinator is bumping generation/attempts
+        const uint32_t kClaimed = 16;
+
+        struct Job {
+            char input[kPathSize];
+            char output[kPathSize];
+            std::atomic<uint32_t> state;
+            std::atomic<uint32_t> generation;   // bumped on every requeue
+            std::atomic<uint64_t> claimed_ms;   // set by the claiming worker, 0 while unclaimed
+            uint32_t attempts;                  // written by the coordinator only
+            int32_t worker;                     // slot that finished it
+            double total_ms;
+            double resample_ms;
+        };
+
+        struct Worker {
+            std::atomic<uint64_t> heartbeat_ms;
+            std::atomic<int32_t> pid;           // 0 = free slot
+            std::atomic<uint32_t> completed;
+            double busy_ms;
+        };
+
+        struct Segment {
+            uint32_t magic;
+            uint32_t job_count;
+            std::atomic<uint32_t> joined;       // highest slot ever used + 1
+            std::atomic<uint32_t> shutdown;
+            float scale;
+            int32_t output_width;
+            int32_t output_height;
+            int32_t taps;
+            int32_t quality;
+            int32_t precision;
+            char filter[16];
+            Worker workers[kMaxWorkers];
+            Job jobs[1];                        // job_count entries
+        };
+
+        static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+                      "shared-memory atomics must be lock-free");
+
+        size_t segment_size(uint32_t job_count) {
+            return sizeof(Segment) + sizeof(Job) * (std::max<uint32_t>(job_count, 1) - 1);
+        }
+
+        uint64_t now_ms() {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts); // system-wide, so comparable across processes
+            return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+        }
+
+        Segment* map_segment(const std::string& name, bool create, uint32_t job_count) {
+            int fd = shm_open(name.c_str(), create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR, 0600);
+            if (fd < 0) throw std::runtime_error("Cannot open shared segment " + name + ": " + std::strerror(errno));
+
+            size_t size;
+            if (create) {
+                size = segment_size(job_count);
+                if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                    close(fd);
+                    throw std::runtime_error("Cannot size shared segment " + name);
+                }
+            }
+            else {
+                struct stat st;
+                fstat(fd, &st);
+                size = static_cast<size_t>(st.st_size);
+            }
+
+            void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (address == MAP_FAILED) throw std::runtime_error("Cannot map shared segment " + name);
+
+            Segment* segment = static_cast<Segment*>(address);
+            if (!create && (size < sizeof(Segment) || segment->magic != kMagic || size < segment_size(segment->job_count))) {
+                munmap(address, size);
+                throw std::runtime_error("Not a batch segment: " + name);
+            }
+            return segment;
+        }
+
+        Pipeline::Params segment_params(const Segment& segment) {
+            Pipeline::Params params;
+            params.scale = segment.scale;
+            params.output_width = segment.output_width;
+            params.output_height = segment.output_height;
+            params.taps = segment.taps;
+            params.quality = segment.quality;
+            params.precision = static_cast<Precision>(segment.precision);
+            params.filter = segment.filter;
+            return params;
+        }
+
+        pid_t spawn_worker(const std::string& name, int omp_threads) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                if (!getenv("OMP_NUM_THREADS")) setenv("OMP_NUM_THREADS", std::to_string(omp_threads).c_str(), 1);
+                execl("/proc/self/exe", "lanczos-worker", "--shard-worker", name.c_str(), static_cast<char*>(nullptr));
+                _exit(127);
+            }
+            return pid;
+        }
+
+        bool owns_jobs(const Segment& segment, uint32_t slot) {
+            for (uint32_t i = 0; i < segment.job_count; ++i) {
+                if (segment.jobs[i].state.load() == kClaimed + slot) return true;
+            }
+            return false;
+        }
+
+        // Claims the first free worker slot; slots of dead workers are handed back by the
+        // coordinator once their jobs are requeued. Returns kMaxWorkers when all are taken.
+        uint32_t join(Segment& segment) {
+            for (uint32_t slot = 0; slot < static_cast<uint32_t>(kMaxWorkers); ++slot) {
+                int32_t expected = 0;
+                if (!segment.workers[slot].pid.compare_exchange_strong(expected, getpid())) continue;
+                segment.workers[slot].heartbeat_ms.store(now_ms());
+                uint32_t joined = segment.joined.load();
+                while (joined < slot + 1 && !segment.joined.compare_exchange_weak(joined, slot + 1)) {}
+                return slot;
+            }
+            return kMaxWorkers;
+        }
+
+        bool all_finished(const Segment& segment) {
+            for (uint32_t i = 0; i < segment.job_count; ++i) {
+                uint32_t state = segment.jobs[i].state.load();
+                if (state != kDone && state != kFailed) return false;
+            }
+            return true;
+        }
+    }
+
+    int coordinate(const Options& options) {
+        std::vector<std::string> files = Batch::list_jpeg_files(options.input_dir);
+        fs::create_directories(options.output_dir);
+
+        const std::string name = "/lanczos_batch_" + std::to_string(getpid());
+        const uint32_t job_count = static_cast<uint32_t>(files.size());
+        Segment* segment = map_segment(name, true, job_count);
+
+        segment->magic = kMagic;
+        segment->job_count = job_count;
+        segment->scale = options.params.scale;
+        segment->output_width = options.params.output_width;
+        segment->output_height = options.params.output_height;
+        segment->taps = options.params.taps;
+        segment->quality = options.params.quality;
+        segment->precision = static_cast<int32_t>(options.params.precision);
+        std::strncpy(segment->filter, options.params.filter.c_str(), sizeof(segment->filter) - 1);
+        for (uint32_t i = 0; i < job_count; ++i) {
+            Job& job = segment->jobs[i];
+            std::string output = (fs::path(options.output_dir) / fs::path(files[i]).filename()).string();
+            if (files[i].size() >= kPathSize || output.size() >= kPathSize) {
+                shm_unlink(name.c_str());
+                throw std::runtime_error("Path too long for batch manifest: " + files[i]);
+            }
+            std::strcpy(job.input, files[i].c_str());
+            std::strcpy(job.output, output.c_str());
+            job.worker = -1;
+        }
+
+        std::cout << "Coordinator: " << job_count << " jobs in " << name << ", " << options.workers << " workers\n";
+
+        const int omp_threads = std::max(1, omp_get_num_procs() / std::max(options.workers, 1));
+        std::map<pid_t, bool> children;
+        for (int i = 0; i < options.workers; ++i) children[spawn_worker(name, omp_threads)] = true;
+
+        const size_t restart_limit = static_cast<size_t>(job_count) * options.max_attempts + options.workers;
+        size_t restarts = 0;
+        std::vector<uint32_t> retiring;     // slots of dead workers, freed once their jobs are requeued
+        auto retire = [&retiring](uint32_t s) {
+            if (std::find(retiring.begin(), retiring.end(), s) == retiring.end()) retiring.push_back(s);
+        };
+
+        while (!all_finished(*segment)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // Restart child workers that died while work remains.
+            int status;
+            pid_t pid;
+            while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+                children.erase(pid);
+                for (uint32_t s = 0; s < std::min<uint32_t>(segment->joined.load(), kMaxWorkers); ++s) {
+                    if (segment->workers[s].pid.load() != pid) continue;
+                    segment->workers[s].heartbeat_ms.store(0);
+                    retire(s);
+                }
+                bool crashed = !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+                if (crashed) {
+                    std::cerr << "Worker " << pid << " exited abnormally\n";
+                    if (!all_finished(*segment) && restarts++ < restart_limit) children[spawn_worker(name, omp_threads)] = true;
+                }
+            }
+
+            // External workers are not our children; a stale heartbeat is all we see of their death.
+            const uint64_t now = now_ms();
+            for (uint32_t s = 0; s < std::min<uint32_t>(segment->joined.load(), kMaxWorkers); ++s) {
+                const Worker& worker = segment->workers[s];
+                pid_t worker_pid = worker.pid.load();
+                if (worker_pid > 0 && !children.count(worker_pid) &&
+                    worker.heartbeat_ms.load() + options.heartbeat_timeout_ms <= now) retire(s);
+            }
+
+            // Requeue jobs whose owner stopped sending heartbeats, or that overran the job
+            // timeout (the heartbeat thread keeps beating when the job itself is wedged).
+            for (uint32_t i = 0; i < job_count; ++i) {
+                Job& job = segment->jobs[i];
+                uint32_t state = job.state.load();
+                if (state < kClaimed) continue;
+                const Worker& owner = segment->workers[state - kClaimed];
+                const uint64_t claimed = job.claimed_ms.load();
+                const bool overran = claimed != 0 && claimed + options.job_timeout_ms <= now;
+                if (!overran && owner.heartbeat_ms.load() + options.heartbeat_timeout_ms > now) continue;
+
+                // Park the job in kRequeuing so the owner's completion CAS fails and nobody can
+                // claim it before the new generation is visible.
+                if (!job.state.compare_exchange_strong(state, kRequeuing)) continue;
+                // A stalled child would otherwise keep running the job next to its new owner.
+                pid_t owner_pid = owner.pid.load();
+                if (owner_pid > 0 && children.count(owner_pid)) kill(owner_pid, SIGKILL);
+                job.claimed_ms.store(0);
+                job.generation.fetch_add(1);
+                ++job.attempts;
+                job.state.store((static_cast<int>(job.attempts) >= options.max_attempts) ? kFailed : kPending);
+                std::cerr << "Requeued " << job.input << (overran ? " after timeout" : "") << " (retry " << job.attempts << ")\n";
+            }
+
+            // Hand slots of dead workers back once none of their jobs is still claimed.
+            retiring.erase(std::remove_if(retiring.begin(), retiring.end(), [&](uint32_t s) {
+                if (owns_jobs(*segment, s)) return false;
+                segment->workers[s].pid.store(0);
+                return true;
+            }), retiring.end());
+
+            if (children.empty() && options.workers > 0 && restarts >= restart_limit) break;
+        }
+
+        segment->shutdown.store(1);
+        for (const auto& child : children) waitpid(child.first, nullptr, 0);
+
+        int failures = 0;
+        for (uint32_t i = 0; i < job_count; ++i) {
+            const Job& job = segment->jobs[i];
+            bool done = job.state.load() == kDone;
+            if (!done) ++failures;
+            std::cout << (done ? "Done   " : "Failed ") << job.output << std::fixed << std::setprecision(1)
+                      << "  worker=" << job.worker << " attempts=" << job.attempts + 1
+                      << " total_ms=" << job.total_ms << " resample_ms=" << job.resample_ms << "\n";
+        }
+        for (uint32_t s = 0; s < std::min<uint32_t>(segment->joined.load(), kMaxWorkers); ++s) {
+            const Worker& worker = segment->workers[s];
+            std::cout << "Worker " << s << " (pid " << worker.pid.load() << "): " << worker.completed.load()
+                      << " jobs, " << worker.busy_ms << " ms busy\n";
+        }
+
+        munmap(segment, segment_size(job_count));
+        shm_unlink(name.c_str());
+        return failures;
+    }
+
+    int work(const std::string& segment_name) {
+        Segment* segment = map_segment(segment_name, false, 0);
+        const uint32_t slot = join(*segment);
+        if (slot >= static_cast<uint32_t>(kMaxWorkers)) {
+            std::cerr << "Too many workers for " << segment_name << "\n";
+            munmap(segment, segment_size(segment->job_count));
+            return 1;
+        }
+
+        Worker& self = segment->workers[slot];
+
+        // The coordinator frees our slot if it presumed us dead (e.g. after SIGSTOP); stop
+        // beating and claiming then, since the slot may already belong to another worker.
+        auto evicted = [&self] { return self.pid.load() != getpid(); };
+        std::atomic<bool> running(true);
+        std::thread heartbeat([&] {
+            while (running.load() && !evicted()) {
+                self.heartbeat_ms.store(now_ms());
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            }
+        });
+
+        const Pipeline::Params params = segment_params(*segment);
+        while (!segment->shutdown.load() && !all_finished(*segment) && !evicted()) {
+            bool claimed = false;
+            for (uint32_t i = 0; i < segment->job_count && !claimed; ++i) {
+                Job& job = segment->jobs[i];
+                uint32_t expected = kPending;
+                if (!job.state.compare_exchange_strong(expected, kClaimed + slot)) continue;
+                claimed = true;
+                job.claimed_ms.store(now_ms());
+                const uint32_t generation = job.generation.load();
+                // Render into a private file: a worker presumed dead may still be running this
+                // job, and only a complete image may ever appear under job.output.
+                const std::string temp = std::string(job.output) + "." + std::to_string(getpid()) + "." +
+                                         std::to_string(generation) + ".tmp";
+
+                auto start = std::chrono::steady_clock::now();
+                double resample_ms = 0.0;
+                bool ok = true;
+                try {
+                    std::vector<unsigned char> image_data;
+                    int width = 0, height = 0, channels = 0;
+                    JPEGProcessor::read_jpeg_memory(Pipeline::read_file_bytes(job.input), image_data, width, height, channels);
+                    if (image_data.empty()) throw std::runtime_error("could not decode JPEG");
+
+                    int new_width, new_height;
+                    Pipeline::resolve_size(params, width, height, new_width, new_height);
+                    auto resample_start = std::chrono::steady_clock::now();
+                    std::vector<unsigned char> output = Pipeline::resample(image_data, width, height, channels, new_width, new_height, params);
+                    resample_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - resample_start).count();
+                    JPEGProcessor::write_jpeg_file_parallel(temp, output, new_width, new_height, channels, params.quality);
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Worker " << slot << ": " << job.input << ": " << e.what() << "\n";
+                    ok = false;
+                }
+                double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                // A job requeued meanwhile (we were presumed dead) belongs to its new owner.
+                std::error_code ignored;
+                if (job.generation.load() != generation || job.state.load() != kClaimed + slot) {
+                    fs::remove(temp, ignored);
+                    continue;
+                }
+                // rename() is atomic, so even if we lose a race with the requeue here the output
+                // is a complete image of the same input.
+                if (ok && std::rename(temp.c_str(), job.output) != 0) {
+                    std::cerr << "Worker " << slot << ": cannot rename " << temp << ": " << std::strerror(errno) << "\n";
+                    ok = false;
+                }
+                if (!ok) fs::remove(temp, ignored);
+                job.worker = static_cast<int32_t>(slot);
+                job.total_ms = total_ms;
+                job.resample_ms = resample_ms;
+                uint32_t mine = kClaimed + slot;
+                job.state.compare_exchange_strong(mine, ok ? kDone : kFailed);
+                self.completed.fetch_add(1);
+                self.busy_ms += total_ms;
+            }
+            // Everything left is claimed by others; wait in case some are requeued.
+            if (!claimed) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        running.store(false);
+        heartbeat.join();
+        munmap(segment, segment_size(segment->job_count));
+        return 0;
+    }
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include "pipeline.h"
+
+// Multi-process batch execution on one host.
+//
+// The coordinator publishes a manifest of jobs (every JPEG in input_dir) in a POSIX
+// shared-memory segment and starts `workers` copies of this executable in worker mode;
+// more workers (e.g. one per NUMA node or container sharing /dev/shm) may join with
+// --shard-worker <name>. Workers claim jobs with a CAS on the job's state, run the normal
+// pipeline, and write status and timings back into the segment. Each worker publishes a
+// heartbeat from a side thread. When it stops (crash, kill, OOM), or a job stays claimed
+// longer than job_timeout_ms (a wedged job keeps the heartbeat alive), the coordinator puts
+// the job back in the queue, up to max_attempts per job, kills the owner if it is a child,
+// and restarts crashed child workers while work remains. Outputs are rendered to a temporary
+// file and renamed into place, and slots of dead workers, child or external, are reused.
+namespace ShardedBatch {
+    struct Options {
+        std::string input_dir;
+        std::string output_dir;
+        Pipeline::Params params;
+        int workers = 2;                  // child worker processes to start (0 = external only)
+        int heartbeat_timeout_ms = 5000;
+        int job_timeout_ms = 10 * 60 * 1000; // per claimed job; generous, large frames take a while
+        int max_attempts = 3;
+    };
+
+    // Returns the number of jobs that failed.
+    int coordinate(const Options& options);
+
+    int work(const std::string& segment_name);
+}
\ No newline at end of file
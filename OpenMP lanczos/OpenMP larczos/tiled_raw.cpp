@@ -0,0 +1,226 @@
+#include "tiled_raw.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char kMagic[8] = { 'L', 'Z', 'T', 'I', 'L', 'E', 'S', '1' };
+    const uint64_t kDataOffset = 4096;
+
+    // a * b, false on 64-bit overflow.
+    bool multiply(uint64_t a, uint64_t b, uint64_t& result) {
+        if (a != 0 && b > UINT64_MAX / a) return false;
+        result = a * b;
+        return true;
+    }
+}
+
+TiledRaw TiledRaw::create(const std::string& path, int width, int height, int channels, Tiles::Size tile) {
+    if (width <= 0 || height <= 0 || channels < 1 || channels > 4 || tile.width <= 0 || tile.height <= 0) {
+        throw std::invalid_argument("Invalid tiled output geometry");
+    }
+
+    uint64_t tiles = static_cast<uint64_t>(Tiles::count(width, tile.width)) * Tiles::count(height, tile.height);
+    uint64_t size = kDataOffset + tiles * tile.width * tile.height * channels;
+
+    TiledRaw raw;
+    raw.map(path, true, size);
+
+    Header header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.width = width;
+    header.height = height;
+    header.channels = channels;
+    header.tile_width = tile.width;
+    header.tile_height = tile.height;
+    header.data_offset = kDataOffset;
+    std::memcpy(raw.base, &header, sizeof(header));
+    return raw;
+}
+
+TiledRaw TiledRaw::open(const std::string& path) {
+    TiledRaw raw;
+    raw.map(path, false, 0);
+
+    if (raw.mapped_size < sizeof(Header) || std::memcmp(raw.header().magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a tiled raw container: " + path);
+    }
+
+    // Validate the header before any geometry (columns(), tile_bytes()) is derived from it.
+    const Header& header = raw.header();
+    const uint32_t int_max = static_cast<uint32_t>(INT32_MAX);
+    if (header.width == 0 || header.height == 0 || header.width > int_max || header.height > int_max ||
+        header.tile_width == 0 || header.tile_height == 0 || header.tile_width > int_max || header.tile_height > int_max ||
+        header.channels < 1 || header.channels > 4 ||
+        header.data_offset < sizeof(Header) || header.data_offset > raw.mapped_size) {
+        throw std::runtime_error("Corrupt tiled raw header: " + path);
+    }
+
+    const uint64_t columns = (static_cast<uint64_t>(header.width) + header.tile_width - 1) / header.tile_width;
+    const uint64_t rows = (static_cast<uint64_t>(header.height) + header.tile_height - 1) / header.tile_height;
+    uint64_t tile_bytes = 0, tiles = 0, data_size = 0;
+    if (!multiply(header.tile_width, header.tile_height, tile_bytes) || !multiply(tile_bytes, header.channels, tile_bytes) ||
+        !multiply(columns, rows, tiles) || !multiply(tiles, tile_bytes, data_size) ||
+        data_size > raw.mapped_size - header.data_offset) {
+        throw std::runtime_error("Truncated tiled raw container: " + path);
+    }
+    return raw;
+}
+
+TiledRaw::TiledRaw(TiledRaw&& other) noexcept {
+    *this = std::move(other);
+}
+
+TiledRaw& TiledRaw::operator=(TiledRaw&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        std::swap(base, other.base);
+        std::swap(mapped_size, other.mapped_size);
+        std::swap(writable, other.writable);
+#ifdef _WIN32
+        std::swap(file, other.file);
+        std::swap(mapping, other.mapping);
+#else
+        std::swap(fd, other.fd);
+#endif
+    }
+    return *this;
+}
+
+TiledRaw::~TiledRaw() {
+    unmap();
+}
+
+size_t TiledRaw::tile_bytes() const {
+    return static_cast<size_t>(header().tile_width) * header().tile_height * header().channels;
+}
+
+const unsigned char* TiledRaw::tile(int column, int row) const {
+    if (column < 0 || row < 0 || column >= columns() || row >= rows()) {
+        throw std::out_of_range("Tile index out of range");
+    }
+    return base + header().data_offset + (static_cast<size_t>(row) * columns() + column) * tile_bytes();
+}
+
+void TiledRaw::read_rows(int first_row, int count, unsigned char* destination) const {
+    if (first_row < 0 || count < 0 || first_row + count > height()) {
+        throw std::out_of_range("Row range out of range");
+    }
+    const Tiles::Size size = tile_size();
+    const size_t pixel = header().channels;
+    const size_t row_bytes = static_cast<size_t>(width()) * pixel;
+    for (int y = first_row; y < first_row + count; ++y) {
+        unsigned char* out = destination + static_cast<size_t>(y - first_row) * row_bytes;
+        for (int column = 0; column < columns(); ++column) {
+            const int x0 = column * size.width;
+            const size_t bytes = static_cast<size_t>(std::min(size.width, width() - x0)) * pixel;
+            const unsigned char* source = tile(column, y / size.height) + static_cast<size_t>(y % size.height) * size.width * pixel;
+            std::copy_n(source, bytes, out + x0 * pixel);
+        }
+    }
+}
+
+unsigned char* TiledRaw::row(const Tiles::Tile& tile, int y) {
+    const Tiles::Size size = tile_size();
+    return const_cast<unsigned char*>(this->tile(tile.x0 / size.width, tile.y0 / size.height))
+         + static_cast<size_t>(y - tile.y0) * size.width * header().channels;
+}
+
+#ifdef _WIN32
+void TiledRaw::map(const std::string& path, bool writable, uint64_t size) {
+    file = CreateFileA(path.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                       FILE_SHARE_READ, nullptr, writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        throw std::runtime_error("Error opening tiled output: " + path);
+    }
+
+    if (!writable) {
+        LARGE_INTEGER file_size;
+        GetFileSizeEx(file, &file_size);
+        size = static_cast<uint64_t>(file_size.QuadPart);
+    }
+
+    mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                 static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+    if (mapping) {
+        base = static_cast<unsigned char*>(MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!base) {
+        unmap();
+        throw std::runtime_error("Error mapping tiled output: " + path);
+    }
+    mapped_size = size;
+    this->writable = writable;
+}
+
+void TiledRaw::unmap() {
+    if (base) UnmapViewOfFile(base);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+    base = nullptr;
+    mapping = file = nullptr;
+    mapped_size = 0;
+}
+
+void TiledRaw::flush(bool wait) {
+    if (!base || !writable) return;
+    FlushViewOfFile(base, 0);
+    if (wait) FlushFileBuffers(file);
+}
+#else
+void TiledRaw::map(const std::string& path, bool writable, uint64_t size) {
+    fd = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC), 0644);
+    if (fd < 0) throw std::runtime_error("Error opening tiled output: " + path);
+
+    if (writable) {
+        // Sparse on most filesystems: untouched tiles cost no disk until written.
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            unmap();
+            throw std::runtime_error("Error sizing tiled output: " + path);
+        }
+    }
+    else {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            unmap();
+            throw std::runtime_error("Error reading tiled output: " + path);
+        }
+        size = static_cast<uint64_t>(st.st_size);
+    }
+
+    void* address = size ? mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (address == MAP_FAILED) {
+        unmap();
+        throw std::runtime_error("Error mapping tiled output: " + path);
+    }
+    base = static_cast<unsigned char*>(address);
+    mapped_size = size;
+    this->writable = writable;
+}
+
+void TiledRaw::unmap() {
+    if (base) munmap(base, mapped_size);
+    if (fd >= 0) close(fd);
+    base = nullptr;
+    fd = -1;
+    mapped_size = 0;
+}
+
+void TiledRaw::flush(bool wait) {
+    if (!base || !writable) return;
+    msync(base, mapped_size, wait ? MS_SYNC : MS_ASYNC);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "tiles.h"
+
+// Memory-mapped tiled raw image container, for outputs too large to hold in RAM or to
+// encode as one JPEG.
+//
+// Layout (host byte order, little-endian on all supported targets):
+//   [0, 40)            Header, see below
+//   [data_offset, ...) tiles in row-major tile order, each tile_width * tile_height *
+//                      channels bytes with interleaved pixels; tiles on the right and
+//                      bottom edges keep the full size and are zero-padded.
+// data_offset is page aligned so readers may map individual tiles.
+class TiledRaw {
+public:
+    struct Header {
+        char magic[8];            // "LZTILES1"
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;
+        uint32_t tile_width;
+        uint32_t tile_height;
+        uint32_t reserved;
+        uint64_t data_offset;
+    };
+
+    // Creates (or truncates) the file at its full size and maps it read-write.
+    static TiledRaw create(const std::string& path, int width, int height, int channels, Tiles::Size tile);
+    // Maps an existing container read-only.
+    static TiledRaw open(const std::string& path);
+
+    TiledRaw(TiledRaw&& other) noexcept;
+    TiledRaw& operator=(TiledRaw&& other) noexcept;
+    TiledRaw(const TiledRaw&) = delete;
+    TiledRaw& operator=(const TiledRaw&) = delete;
+    ~TiledRaw();
+
+    int width() const { return static_cast<int>(header().width); }
+    int height() const { return static_cast<int>(header().height); }
+    int channels() const { return static_cast<int>(header().channels); }
+    Tiles::Size tile_size() const { return { static_cast<int>(header().tile_width), static_cast<int>(header().tile_height) }; }
+    int columns() const { return Tiles::count(width(), tile_size().width); }
+    int rows() const { return Tiles::count(height(), tile_size().height); }
+    size_t tile_bytes() const;
+    bool read_only() const { return !writable; }
+
+    const unsigned char* tile(int column, int row) const;
+
+    // Copies image rows [first_row, first_row + count) into `destination` in row-major
+    // order (width * channels bytes per row), without the tile padding.
+    void read_rows(int first_row, int count, unsigned char* destination) const;
+
+    // Where pixel (tile.x0, y) of a tile on this container's grid is stored; used as the
+    // Separable::resample_into destination so workers write straight into the mapping.
+    // Only valid on a container from create().
+    unsigned char* row(const Tiles::Tile& tile, int y);
+
+    // Schedules dirty pages for writeback (synchronously when `wait` is set).
+    void flush(bool wait = false);
+
+private:
+    TiledRaw() = default;
+    const Header& header() const { return *reinterpret_cast<const Header*>(base); }
+    void map(const std::string& path, bool writable, uint64_t size);
+    void unmap();
+
+    unsigned char* base = nullptr;
+    uint64_t mapped_size = 0;
+    bool writable = false;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+
+// Rectangular output tiles shared by the CPU resamplers. Tiles keep each thread's source
+// footprint compact (better cache reuse than row-interleaved pixels) and are handed out
+// dynamically so uneven tiles (e.g. the edge-handled border) balance across threads.
+namespace Tiles {
+    struct Tile {
+        int x0, y0;   // inclusive
+        int x1, y1;   // exclusive
+    };
+
+    struct Size {
+        int width = 64;
+        int height = 64;
+    };
+
+    // Tile size used when a resampler is not given one explicitly. Thread-local so each
+    // job (e.g. on a daemon worker) can apply its own tuned size.
+    inline Size& current_size() {
+        thread_local Size size;
+        return size;
+    }
+
+    // Cancellation flag for resamples started on this thread; once set, parallel_for skips
+    // the tiles it has not started yet. Null means not cancellable.
+    inline const std::atomic<bool>*& current_cancel() {
+        thread_local const std::atomic<bool>* flag = nullptr;
+        return flag;
+    }
+
+    inline int count(int extent, int tile) {
+        return (extent + tile - 1) / tile;
+    }
+
+    template <typename Fn>
+    void parallel_for(int width, int height, Size size, Fn fn) {
+        const int tile_w = std::max(size.width, 1);
+        const int tile_h = std::max(size.height, 1);
+        const int columns = count(width, tile_w);
+        const int total = columns * count(height, tile_h);
+        const std::atomic<bool>* cancel = current_cancel();
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int t = 0; t < total; ++t) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) continue;
+            Tile tile;
+            tile.x0 = (t % columns) * tile_w;
+            tile.y0 = (t / columns) * tile_h;
+            tile.x1 = std::min(tile.x0 + tile_w, width);
+            tile.y1 = std::min(tile.y0 + tile_h, height);
+            fn(tile);
+        }
+    }
+}
\ No newline at end of file
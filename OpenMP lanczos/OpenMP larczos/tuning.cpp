@@ -0,0 +1,170 @@
+#include "tuning.h"
+#include "jpeg_cpu.h"
+#include "pipeline.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <omp.h>
+
+namespace {
+    const std::vector<Tuning::Entry>& active_profile() {
+        static const std::vector<Tuning::Entry> profile = [] {
+            const char* path = std::getenv("LANCZOS_TUNING_PROFILE");
+            return Tuning::load(path ? path : "lanczos_tuning.txt");
+        }();
+        return profile;
+    }
+
+    // Best of two timed runs after one warm-up.
+    double time_config(const std::vector<unsigned char>& image, int width, int height, int channels,
+                       int new_width, int new_height, const Tuning::Config& config) {
+        Pipeline::Params params;
+        params.rgbx = config.rgbx;
+        params.use_profile = false;
+
+        Tuning::ScopedConfig scoped(config);
+        double best = std::numeric_limits<double>::max();
+        for (int run = 0; run < 3; ++run) {
+            double start = omp_get_wtime();
+            Pipeline::resample(image, width, height, channels, new_width, new_height, params);
+            if (run > 0) best = std::min(best, omp_get_wtime() - start);
+        }
+        return best;
+    }
+}
+
+namespace Tuning {
+    std::vector<Entry> load(const std::string& path) {
+        std::vector<Entry> entries;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+
+            std::istringstream fields(line);
+            Entry entry;
+            std::string layout;
+            if (fields >> entry.output_pixels >> entry.config.threads
+                       >> entry.config.tile.width >> entry.config.tile.height >> layout) {
+                entry.config.rgbx = (layout == "rgbx");
+                entries.push_back(entry);
+            }
+        }
+        return entries;
+    }
+
+    bool save(const std::string& path, const std::vector<Entry>& entries) {
+        std::ofstream file(path);
+        if (!file) {
+            std::cerr << "Error opening profile file: " << path << std::endl;
+            return false;
+        }
+        file << "# lanczos autotune profile\n"
+             << "# output_pixels threads tile_width tile_height layout\n";
+        for (const auto& entry : entries) {
+            file << entry.output_pixels << " " << entry.config.threads << " "
+                 << entry.config.tile.width << " " << entry.config.tile.height << " "
+                 << (entry.config.rgbx ? "rgbx" : "rgb") << "\n";
+        }
+        return true;
+    }
+
+    bool lookup(long long output_pixels, Config& config) {
+        const std::vector<Entry>& profile = active_profile();
+        if (profile.empty() || output_pixels <= 0) return false;
+
+        // Nearest measured size on a log scale.
+        double target = std::log(static_cast<double>(output_pixels));
+        const Entry* best = &profile.front();
+        for (const auto& entry : profile) {
+            if (std::abs(std::log(static_cast<double>(entry.output_pixels)) - target) <
+                std::abs(std::log(static_cast<double>(best->output_pixels)) - target)) {
+                best = &entry;
+            }
+        }
+        config = best->config;
+        return true;
+    }
+
+    ScopedConfig::ScopedConfig(const Config& config)
+        : saved_threads(omp_get_max_threads()), saved_tile(Tiles::current_size()) {
+        // Never raise the count: inside a WorkerPool worker the current value is this
+        // worker's share of the cores, and a profile tuned for one job would oversubscribe.
+        if (config.threads > 0) omp_set_num_threads(std::min(config.threads, saved_threads));
+        Tiles::current_size() = config.tile;
+    }
+
+    ScopedConfig::~ScopedConfig() {
+        omp_set_num_threads(saved_threads);
+        Tiles::current_size() = saved_tile;
+    }
+
+    int autotune(const std::string& profile_path, float scale_factor, const std::vector<std::string>& images) {
+        std::vector<int> thread_candidates;
+        int procs = omp_get_num_procs();
+        for (int t = 1; t < procs; t *= 2) thread_candidates.push_back(t);
+        thread_candidates.push_back(procs);
+
+        const Tiles::Size tile_candidates[] = { { 16, 16 }, { 32, 32 }, { 64, 64 }, { 128, 32 }, { 256, 16 }, { 128, 128 } };
+
+        std::vector<Entry> entries;
+        for (const auto& path : images) {
+            std::vector<unsigned char> image;
+            int width = 0, height = 0, channels = 0;
+            JPEGProcessor::read_jpeg_file(path, image, width, height, channels);
+            if (image.empty()) continue;
+
+            Pipeline::Params params;
+            params.scale = scale_factor;
+            int new_width, new_height;
+            Pipeline::resolve_size(params, width, height, new_width, new_height);
+            std::cout << path << ": " << width << "x" << height << " -> " << new_width << "x" << new_height << "\n";
+
+            // Coordinate descent: threads, then tile shape, then layout. The axes interact
+            // only weakly, and a full grid would take too long on large outputs.
+            Config best;
+            double best_time = time_config(image, width, height, channels, new_width, new_height, best);
+            auto consider = [&](const Config& candidate, const std::string& label) {
+                double seconds = time_config(image, width, height, channels, new_width, new_height, candidate);
+                std::cout << "  " << label << ": " << seconds * 1000.0 << " ms\n";
+                if (seconds < best_time) {
+                    best_time = seconds;
+                    best = candidate;
+                }
+            };
+
+            for (int threads : thread_candidates) {
+                Config candidate = best;
+                candidate.threads = threads;
+                consider(candidate, "threads=" + std::to_string(threads));
+            }
+            for (const auto& tile : tile_candidates) {
+                Config candidate = best;
+                candidate.tile = tile;
+                consider(candidate, "tile=" + std::to_string(tile.width) + "x" + std::to_string(tile.height));
+            }
+            if (channels == 3) {
+                Config candidate = best;
+                candidate.rgbx = !best.rgbx;
+                consider(candidate, candidate.rgbx ? "layout=rgbx" : "layout=rgb");
+            }
+
+            std::cout << "  best: threads=" << best.threads << " tile=" << best.tile.width << "x" << best.tile.height
+                      << " layout=" << (best.rgbx ? "rgbx" : "rgb") << " (" << best_time * 1000.0 << " ms)\n";
+            entries.push_back({ static_cast<long long>(new_width) * new_height, best });
+        }
+
+        if (entries.empty()) {
+            std::cerr << "No images could be benchmarked.\n";
+            return 1;
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.output_pixels < b.output_pixels; });
+        if (!save(profile_path, entries)) return 1;
+        std::cout << "Profile written to " << profile_path << "\n";
+        return 0;
+    }
+}
\ No newline at end of file
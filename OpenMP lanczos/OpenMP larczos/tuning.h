@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "tiles.h"
+
+// Per-host tuning of OpenMP thread count, tile size and pixel layout.
+//
+// `--autotune` microbenchmarks candidate configurations on representative images and
+// writes a profile; Pipeline::resample loads it once (LANCZOS_TUNING_PROFILE, default
+// lanczos_tuning.txt in the working directory) and applies the entry whose output size
+// is closest to each request. Without a profile the OpenMP and tile defaults are used.
+namespace Tuning {
+    struct Config {
+        int threads = 0;          // 0 = OpenMP default
+        Tiles::Size tile;
+        bool rgbx = false;
+    };
+
+    struct Entry {
+        long long output_pixels = 0;
+        Config config;
+    };
+
+    std::vector<Entry> load(const std::string& path);
+    bool save(const std::string& path, const std::vector<Entry>& entries);
+
+    // Best known configuration for an output size; false when no profile is loaded.
+    bool lookup(long long output_pixels, Config& config);
+
+    // Applies a configuration to the calling thread for its lifetime, then restores. The
+    // thread count is capped at the caller's current omp_get_max_threads().
+    class ScopedConfig {
+    public:
+        explicit ScopedConfig(const Config& config);
+        ~ScopedConfig();
+
+    private:
+        int saved_threads;
+        Tiles::Size saved_tile;
+    };
+
+    int autotune(const std::string& profile_path, float scale_factor, const std::vector<std::string>& images);
+}
\ No newline at end of file
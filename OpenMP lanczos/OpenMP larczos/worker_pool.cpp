@@ -0,0 +1,74 @@
+#include "worker_pool.h"
+#include <algorithm>
+#include <omp.h>
+
+WorkerPool::WorkerPool(int workers, size_t queue_capacity)
+    : capacity(std::max<size_t>(queue_capacity, 1)) {
+    workers = std::max(workers, 1);
+    for (int i = 0; i < workers; ++i) {
+        threads.emplace_back(&WorkerPool::run, this, workers);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    not_empty.notify_all();
+    not_full.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_full.wait(lock, [this] { return tasks.size() < capacity || stopping; });
+    if (stopping) return;
+    tasks.push_back(std::move(task));
+    lock.unlock();
+    not_empty.notify_one();
+}
+
+bool WorkerPool::try_submit(std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (tasks.size() >= capacity || stopping) return false;
+    tasks.push_back(std::move(task));
+    lock.unlock();
+    not_empty.notify_one();
+    return true;
+}
+
+size_t WorkerPool::queued() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size();
+}
+
+int WorkerPool::active() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return running;
+}
+
+void WorkerPool::run(int worker_count) {
+    // Split the OpenMP threads between workers so concurrent jobs do not oversubscribe.
+    omp_set_num_threads(std::max(1, omp_get_num_procs() / worker_count));
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this] { return !tasks.empty() || stopping; });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            ++running;
+        }
+        not_full.notify_one();
+
+        task();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        --running;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of long-lived threads fed from a bounded FIFO. submit() blocks while the
+// queue is full, which pushes backpressure onto whoever is producing work.
+class WorkerPool {
+public:
+    WorkerPool(int workers, size_t queue_capacity);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(std::function<void()> task);
+    bool try_submit(std::function<void()> task);
+
+    size_t queued() const;
+    int active() const;
+    int workers() const { return static_cast<int>(threads.size()); }
+
+private:
+    void run(int worker_count);
+
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> tasks;
+    size_t capacity;
+    int running = 0;
+    bool stopping = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+};